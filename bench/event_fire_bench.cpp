@@ -0,0 +1,67 @@
+// Fires an event with a plain listener and with a listener taking a user pointer, and reports the time per fire.
+
+#include <chrono>
+
+#include <simple-logger.hpp>
+
+#include "event.hpp"
+
+static constexpr uint64_t FIRE_COUNT = 10'000'000;
+
+static uint64_t plain_listener_count = 0;
+
+static void on_plain_event(uint16_t, EventContext ctx)
+{
+	plain_listener_count += ctx.data.u64[0];
+}
+
+static void on_user_event(uint16_t, EventContext ctx, void* user_data)
+{
+	*static_cast<uint64_t*>(user_data) += ctx.data.u64[0];
+}
+
+// Fires an event and returns the nanoseconds spent per fire.
+static double measure_fires(uint16_t event_code)
+{
+	EventContext ctx {};
+	ctx.data.u64[0] = 1;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t i = 0; i < FIRE_COUNT; i++)
+	{
+		event_fire(event_code, ctx);
+	}
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / FIRE_COUNT;
+}
+
+int main()
+{
+	if (!event_init())
+	{
+		return 1;
+	}
+
+	uint64_t user_listener_count = 0;
+
+	event_add_listener(EventCodes::ON_KEY_DOWN, on_plain_event);
+	event_add_listener(EventCodes::ON_KEY_UP, on_user_event, &user_listener_count);
+
+	double plain_ns = measure_fires(EventCodes::ON_KEY_DOWN);
+	double user_ns = measure_fires(EventCodes::ON_KEY_UP);
+
+	if (plain_listener_count != FIRE_COUNT || user_listener_count != FIRE_COUNT)
+	{
+		sl::log_error("Listeners were invoked {} and {} times instead of {}.", plain_listener_count, user_listener_count,
+			FIRE_COUNT);
+		return 1;
+	}
+
+	sl::log_info("Plain listener: {:.2f} ns per fire.", plain_ns);
+	sl::log_info("User pointer listener: {:.2f} ns per fire.", user_ns);
+
+	event_shutdown();
+
+	return 0;
+}
@@ -0,0 +1,105 @@
+// Measures how many ray-box and frustum-box tests per second the scalar and 8-wide kernels run.
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <simple-logger.hpp>
+
+#include "math/aabb.hpp"
+#include "math/frustum.hpp"
+
+// Powers of two, so the loops can wrap indices with a mask.
+static constexpr uint32_t BOX_COUNT = 4096;
+static constexpr uint32_t RAY_COUNT = 4096;
+
+static constexpr uint64_t TEST_COUNT = 20'000'000;
+
+// Runs `body` for every index, and returns the millions of tests per second, given `tests_per_call` per call.
+template<typename F>
+static double measure_rate(uint64_t call_count, uint64_t tests_per_call, F&& body)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < call_count; i++)
+    {
+        body(i);
+    }
+
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return static_cast<double>(call_count * tests_per_call) / elapsed_s * 1e-6;
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 3.0f);
+
+    std::vector<AABB> boxes(BOX_COUNT);
+    std::vector<Ray> rays(RAY_COUNT);
+
+    for (AABB& box : boxes)
+    {
+        vector3f center { position(rng), position(rng), position(rng) };
+        vector3f half_extent { extent(rng), extent(rng), extent(rng) };
+
+        box = AABB { center - half_extent, center + half_extent };
+    }
+
+    for (Ray& ray : rays)
+    {
+        vector3f direction { position(rng), position(rng), position(rng) };
+
+        ray = Ray::create(vector3f { position(rng), position(rng), position(rng) }, normalize(direction));
+    }
+
+    std::vector<AABBx8> box_groups;
+    std::vector<Rayx8> ray_groups;
+
+    for (uint32_t i = 0; i < BOX_COUNT; i += 8) box_groups.push_back(AABBx8::load(&boxes[i]));
+    for (uint32_t i = 0; i < RAY_COUNT; i += 8) ray_groups.push_back(Rayx8::load(&rays[i]));
+
+    Frustum frustum = Frustum::from_matrix(
+        matrix4f::perspective(1.2f, 1.5f, 0.1f, 50.0f) *
+        matrix4f::look_at(vector3f { 0.0f, 0.0f, 0.0f }, vector3f { 0.0f, 0.0f, -1.0f }, vector3f { 0.0f, 1.0f, 0.0f })
+    );
+
+    // Accumulates the results, so the tests can't be optimized away.
+    uint64_t hit_count = 0;
+    float8 t_enter;
+
+    double ray_box = measure_rate(TEST_COUNT, 1, [&](uint64_t i) {
+        hit_count += ray_intersect_aabb(rays[i & (RAY_COUNT - 1)], boxes[(i * 7) & (BOX_COUNT - 1)], 20.0f).has_value();
+    });
+
+    double ray_boxes = measure_rate(TEST_COUNT / 8, 8, [&](uint64_t i) {
+        const AABBx8& group = box_groups[(i * 7) & (BOX_COUNT / 8 - 1)];
+
+        hit_count += ray_intersect_aabb(rays[i & (RAY_COUNT - 1)], group, 20.0f, t_enter);
+    });
+
+    double rays_box = measure_rate(TEST_COUNT / 8, 8, [&](uint64_t i) {
+        const Rayx8& group = ray_groups[i & (RAY_COUNT / 8 - 1)];
+
+        hit_count += ray_intersect_aabb(group, boxes[(i * 7) & (BOX_COUNT - 1)], float8::broadcast(20.0f), t_enter);
+    });
+
+    double frustum_box = measure_rate(TEST_COUNT, 1, [&](uint64_t i) {
+        hit_count += static_cast<uint64_t>(frustum_classify_aabb(frustum, boxes[i & (BOX_COUNT - 1)]));
+    });
+
+    double frustum_boxes = measure_rate(TEST_COUNT / 8, 8, [&](uint64_t i) {
+        hit_count += frustum_classify_aabb(frustum, box_groups[i & (BOX_COUNT / 8 - 1)]).inside;
+    });
+
+    sl::log_info("Ray against box: {:.0f} M tests/s.", ray_box);
+    sl::log_info("Ray against 8 boxes: {:.0f} M tests/s.", ray_boxes);
+    sl::log_info("8 rays against box: {:.0f} M tests/s.", rays_box);
+    sl::log_info("Frustum against box: {:.0f} M tests/s.", frustum_box);
+    sl::log_info("Frustum against 8 boxes: {:.0f} M tests/s.", frustum_boxes);
+    sl::log_info("Checksum {}.", hit_count);
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+// Generates chunks and evicts the oldest ones, as streaming does while the camera moves, and reports the time per
+// chunk and the memory the chunks use before and after compaction.
+
+#include <chrono>
+#include <deque>
+
+#include <simple-logger.hpp>
+
+#include "container/slot_map.hpp"
+#include "voxel/voxel_octree.hpp"
+
+static constexpr uint8_t CHUNK_DEPTH = 5;
+static constexpr uint32_t CHUNK_COUNT = 8192;
+static constexpr uint32_t LOADED_CHUNK_COUNT = 512;
+
+// Fills a chunk with rolling terrain, so its nodes and bricks grow in the order generation touches them.
+static void generate_chunk(VoxelOctree& octree, uint32_t chunk_idx)
+{
+    uint64_t size = 1ull << CHUNK_DEPTH;
+
+    for (uint64_t z = 0; z < size; z++)
+    {
+        for (uint64_t x = 0; x < size; x++)
+        {
+            uint64_t height = (x * 3 + z * 5 + chunk_idx * 7) % size;
+
+            for (uint64_t y = 0; y <= height; y++)
+            {
+                octree.set_voxel(VoxelOctree::interleave_octree_coordinate(x, y, z), 1 + (y + chunk_idx) % 4);
+            }
+        }
+    }
+}
+
+int main()
+{
+    SlotMap<VoxelOctree> chunks;
+    std::deque<SlotMapHandle> handles;
+
+    uint64_t generated_memory_usage = 0;
+    uint64_t peak_memory_usage = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t chunk_idx = 0; chunk_idx < CHUNK_COUNT; chunk_idx++)
+    {
+        auto octree = VoxelOctree::create(CHUNK_DEPTH);
+
+        if (!octree.has_value())
+        {
+            sl::log_error("Failed to create chunk {}.", chunk_idx);
+            return 1;
+        }
+
+        generate_chunk(*octree, chunk_idx);
+
+        generated_memory_usage += octree->get_memory_usage();
+
+        // Streaming compacts generated chunks before they are stored.
+        while (octree->needs_compaction() && octree->compact_step(UINT32_MAX) > 0) {}
+
+        handles.push_back(chunks.insert(std::move(*octree)));
+
+        if (handles.size() > LOADED_CHUNK_COUNT)
+        {
+            chunks.remove(handles.front());
+            handles.pop_front();
+        }
+
+        if (chunk_idx % LOADED_CHUNK_COUNT == 0)
+        {
+            uint64_t memory_usage = 0;
+
+            for (const VoxelOctree& chunk : chunks)
+            {
+                memory_usage += chunk.get_memory_usage();
+            }
+
+            peak_memory_usage = std::max(peak_memory_usage, memory_usage);
+        }
+    }
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    sl::log_info(
+        "Churned {} chunks in {:.1f} ms, {:.2f} us per chunk.",
+        CHUNK_COUNT,
+        elapsed_ms,
+        elapsed_ms * 1000.0 / CHUNK_COUNT
+    );
+    sl::log_info("Memory of a generated chunk before compaction: {:.1f} KiB.", generated_memory_usage / 1024.0 / CHUNK_COUNT);
+    sl::log_info(
+        "Peak memory of {} loaded chunks: {:.2f} MiB, {:.1f} KiB per chunk.",
+        LOADED_CHUNK_COUNT,
+        peak_memory_usage / (1024.0 * 1024.0),
+        peak_memory_usage / 1024.0 / LOADED_CHUNK_COUNT
+    );
+
+    return 0;
+}
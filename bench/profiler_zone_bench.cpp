@@ -0,0 +1,57 @@
+// Records zones through the profiler, and reports the time per zone against the target of staying well under 50 ns.
+
+#include <chrono>
+
+#include <simple-logger.hpp>
+
+#include "profiler.hpp"
+
+static constexpr uint64_t ZONE_COUNT = 10'000'000;
+
+static constexpr double ZONE_TARGET_NS = 50.0;
+
+// Returns the nanoseconds spent per call of fn, which is called ZONE_COUNT times.
+template<typename F>
+static double measure(F&& fn)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t i = 0; i < ZONE_COUNT; i++)
+	{
+		fn(i);
+	}
+
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ZONE_COUNT;
+}
+
+int main()
+{
+	profiler_init();
+
+	// Keeps the timestamps alive, so the reads are not optimized out.
+	uint64_t tick_sum = 0;
+
+	double ticks_ns = measure([&tick_sum](uint64_t) { tick_sum += profiler_get_ticks(); });
+	double record_ns = measure([](uint64_t i) { profiler_record_zone("record", i, i + 1); });
+	double zone_ns = measure([](uint64_t) { ProfilerScope scope("zone"); });
+
+	if (!profiler_thread_buffer || profiler_thread_buffer->zone_count.load() != 2 * ZONE_COUNT)
+	{
+		sl::log_error("No zones were recorded. Configure with INDUSTRIA_PROFILE=ON.");
+		return 1;
+	}
+
+	sl::log_info("Timestamp: {:.2f} ns per read (sum {}).", ticks_ns, tick_sum);
+	sl::log_info("Record: {:.2f} ns per zone, without timestamps.", record_ns);
+	sl::log_info("Zone: {:.2f} ns per zone, the target is under {:.0f} ns.", zone_ns, ZONE_TARGET_NS);
+
+	if (zone_ns >= ZONE_TARGET_NS)
+	{
+		sl::log_warn("Zones are over the target. Reading the timestamp costs {:.2f} ns here, check whether the "
+			"timestamp counter is trapped, as it is on some virtual machines.", ticks_ns);
+	}
+
+	profiler_shutdown();
+
+	return 0;
+}
@@ -1,13 +1,129 @@
 #include "clock.hpp"
 
-#include "platform/platform.hpp"
+#include <simple-logger.hpp>
+
+#ifdef I_CLOCK_TSC
+#ifndef _MSC_VER
+#include <cpuid.h>
+#endif
+#endif
+
+// How long the TSC is measured against the platform clock.
+#define CLOCK_CALIBRATION_TIME_NS 20'000'000
+
+constinit ClockCalibration clock_calibration = {};
+
+#ifdef I_CLOCK_TSC
+
+static bool has_invariant_tsc();
+static void sample_tsc(uint64_t& ticks, uint64_t& ns);
+
+#endif
+
+void clock_init()
+{
+#ifdef I_CLOCK_TSC
+	// Without an invariant TSC, its rate changes with the core frequency and it may stop in sleep states.
+	if (!has_invariant_tsc())
+	{
+		sl::log_info("The CPU has no invariant TSC, falling back to the platform clock.");
+		return;
+	}
+
+	uint64_t start_ticks, start_ns;
+	uint64_t end_ticks, end_ns;
+
+	sample_tsc(start_ticks, start_ns);
+
+	while (platform_get_time_ns() - start_ns < CLOCK_CALIBRATION_TIME_NS) {}
+
+	sample_tsc(end_ticks, end_ns);
+
+	if (end_ticks <= start_ticks)
+	{
+		sl::log_warn("The TSC did not advance during calibration, falling back to the platform clock.");
+		return;
+	}
+
+	clock_calibration.base_ticks = end_ticks;
+	clock_calibration.base_ns = end_ns;
+	clock_calibration.ns_per_tick = ((end_ns - start_ns) << 32) / (end_ticks - start_ticks);
+
+	sl::log_info(
+		"Calibrated the TSC at {} MHz.",
+		static_cast<double>(end_ticks - start_ticks) * 1000.0 / static_cast<double>(end_ns - start_ns)
+	);
+#endif
+}
 
 void Clock::reset()
 {
-	start_time = platform_get_absolute_time();
+	start_time = now();
+}
+
+uint64_t Clock::restart()
+{
+	uint64_t previous_start_time = start_time;
+
+	start_time = now();
+
+	return start_time - previous_start_time;
+}
+
+uint64_t Clock::get_elapsed_time() const
+{
+	return now() - start_time;
+}
+
+double Clock::get_elapsed_seconds() const
+{
+	return static_cast<double>(get_elapsed_time()) * 1e-9;
+}
+
+#ifdef I_CLOCK_TSC
+
+static bool has_invariant_tsc()
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 0x80000000);
+
+	if (static_cast<uint32_t>(regs[0]) < 0x80000007) return false;
+
+	__cpuid(regs, 0x80000007);
+
+	return regs[3] & (1 << 8);
+#else
+	unsigned int eax, ebx, ecx, edx;
+
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) return false;
+
+	return edx & (1 << 8);
+#endif
 }
 
-double Clock::get_elapsed_time() const
+/**
+ * @brief Takes a TSC reading and the platform time at the same moment, as closely as possible.
+ */
+static void sample_tsc(uint64_t& ticks, uint64_t& ns)
 {
-	return platform_get_absolute_time() - start_time;
+	uint64_t best_window = UINT64_MAX;
+
+	// Bracket the platform clock between two TSC reads, and keep the attempt that was interrupted the least.
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		uint64_t before = __rdtsc();
+		uint64_t platform_ns = platform_get_time_ns();
+		uint64_t after = __rdtsc();
+
+		if (after - before < best_window)
+		{
+			best_window = after - before;
+
+			ticks = before + (after - before) / 2;
+			ns = platform_ns;
+		}
+	}
 }
+
+#endif
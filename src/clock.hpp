@@ -1,33 +1,112 @@
 #pragma once
 
+#include <cstdint>
+
+#include "platform/platform.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define I_CLOCK_TSC
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+/**
+ * @brief Converts TSC ticks to nanoseconds. Written once by \ref clock_init.
+ */
+struct ClockCalibration
+{
+	// A TSC reading and the platform time it was taken at.
+	uint64_t base_ticks;
+	uint64_t base_ns;
+
+	// Nanoseconds per tick in 32.32 fixed point. 0 if the TSC is not used.
+	uint64_t ns_per_tick;
+};
+
+extern constinit ClockCalibration clock_calibration;
+
+/**
+ * @brief Calibrates \ref Clock::now against \ref platform_get_time_ns. Call once at startup, before other threads use
+ * clocks.
+ *
+ * Until then, and on CPUs without an invariant TSC, \ref Clock::now falls back to \ref platform_get_time_ns.
+ */
+void clock_init();
+
 /**
  * @brief The clock data.
- * 
+ *
  * A clock can be used in many ways; to store a certain moment in time, to calculate the elapsed time since a moment in
  * time, etc.
  */
 struct Clock
 {
 	/**
-	 * @brief A point in time in seconds.
+	 * @brief A point in time in nanoseconds.
 	 */
-	double start_time;
+	uint64_t start_time;
 
 	/**
 	 * @brief Resets the clock, setting the \ref start_time to the current time.
-	 * 
+	 *
 	 * The stored time is arbitrary, meaning that it has no meaning on its own. This time can only be meaningfully used
 	 * when calculating differences in time.
-	 * 
-	 * @param clock The clock to reset.
 	 */
 	void reset();
 
+	/**
+	 * @brief Resets the clock, returning the time that elapsed since the previous reset in nanoseconds.
+	 *
+	 * Unlike calling \ref get_elapsed_time followed by \ref reset, no time is lost between the two.
+	 */
+	uint64_t restart();
+
+	/**
+	 * @brief Calculates the elapsed time in nanoseconds since the stored \ref start_time and the current time.
+	 */
+	uint64_t get_elapsed_time() const;
+
 	/**
 	 * @brief Calculates the elapsed time in seconds since the stored \ref start_time and the current time.
-	 * 
-	 * @param clock The clock to calculate the elapsed time from.
-	 * @return double The elapsed time in seconds.
 	 */
-	double get_elapsed_time() const;
+	double get_elapsed_seconds() const;
+
+	/**
+	 * @brief Returns the current time in nanoseconds, on the same clock as \ref start_time.
+	 *
+	 * Reads the TSC when it is calibrated, which is cheaper than asking the OS, especially on systems where reading the
+	 * OS clock takes a system call. The calibrated clock may drift from \ref platform_get_time_ns by a few parts per
+	 * million, so times from the two should not be compared.
+	 */
+	static uint64_t now();
 };
+
+inline uint64_t Clock::now()
+{
+#ifdef I_CLOCK_TSC
+	if (clock_calibration.ns_per_tick != 0)
+	{
+		// Another core may read a slightly lower TSC than the one calibrated on.
+		int64_t ticks = static_cast<int64_t>(__rdtsc() - clock_calibration.base_ticks);
+
+		if (ticks < 0) ticks = 0;
+
+#ifdef _MSC_VER
+		uint64_t high;
+		uint64_t low = _umul128(static_cast<uint64_t>(ticks), clock_calibration.ns_per_tick, &high);
+
+		return clock_calibration.base_ns + __shiftright128(low, high, 32);
+#else
+		unsigned __int128 ns = static_cast<unsigned __int128>(ticks) * clock_calibration.ns_per_tick;
+
+		return clock_calibration.base_ns + static_cast<uint64_t>(ns >> 32);
+#endif
+	}
+#endif
+
+	return platform_get_time_ns();
+}
@@ -1,10 +1,30 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <optional>
 
+#include "platform/platform.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief A list of elements that keep their index until they are freed.
+ *
+ * The elements live in a range of address space that is reserved up front and committed page by page as the list
+ * grows, so growing never moves elements and pointers to them stay valid. Only when the reservation is exhausted are
+ * the elements moved into a larger one.
+ *
+ * Alternatively the elements can be allocated from a memory resource, such as a \ref LinearArena. Growing then moves
+ * the elements.
+ */
 template<typename T>
 struct FreeList
 {
@@ -16,8 +36,8 @@ struct FreeList
         using pointer           = T*;  // or also value_type*
         using reference         = T&;  // or also value_type&
 
-        Iterator(uint64_t cur_index, uint64_t capacity, T* data, bool* free_indices)
-            : cur_index {cur_index}, capacity {capacity}, data {data}, free_indices {free_indices} {}
+        Iterator(uint64_t cur_index, uint64_t capacity, T* data, const uint64_t* occupied)
+            : cur_index {cur_index}, capacity {capacity}, data {data}, occupied {occupied} {}
 
         reference operator * () { return data[cur_index]; }
         pointer operator -> () { return data + cur_index; }
@@ -25,18 +45,7 @@ struct FreeList
         // Increment.
         Iterator& operator ++ ()
         {
-            // Find next element.
-            for (uint64_t i = cur_index + 1; i < capacity; i++)
-            {
-                if (!free_indices[i])
-                {
-                    // Found next element.
-                    cur_index = i;
-                    return *this;
-                }
-            }
-
-            cur_index = capacity;
+            cur_index = find_next_occupied(occupied, capacity, cur_index + 1);
             return *this;
         }
 
@@ -50,15 +59,23 @@ struct FreeList
         // Decrement.
         Iterator& operator -- ()
         {
-            // Find next element.
-            for (uint64_t i = cur_index - 1; i >= 0; i--)
+            // Find previous element.
+            uint64_t i = cur_index;
+
+            while (i > 0)
             {
-                if (!free_indices[i])
+                uint64_t word_idx = (i - 1) >> 6;
+
+                // Only consider the bits below i.
+                uint64_t word = occupied[word_idx] & (~0ull >> (63 - ((i - 1) & 63)));
+
+                if (word)
                 {
-                    // Found next element.
-                    cur_index = i;
+                    cur_index = word_idx * 64 + 63 - std::countl_zero(word);
                     return *this;
                 }
+
+                i = word_idx * 64;
             }
 
             cur_index = capacity;
@@ -79,16 +96,24 @@ struct FreeList
         uint64_t cur_index;
         uint64_t capacity;
         T* data;
-        bool* free_indices;
+        const uint64_t* occupied;
     };
 
-    std::allocator<T> alloc;
-    using alloc_traits = std::allocator_traits<decltype(alloc)>;
+    static constexpr uint64_t DEFAULT_MAX_CAPACITY = 1 << 20;
+
+    // The amount of elements that fit in the committed pages.
+    uint64_t capacity = 0;
+
+    // The amount of elements that fit in the reserved range.
+    uint64_t max_capacity = 0;
 
-    uint64_t capacity;
     T* data = nullptr;
 
-    std::unique_ptr<bool[]> free_indices;
+    // One bit per slot, set while the slot holds an element. Bits past the capacity are always clear.
+    uint64_t* occupied = nullptr;
+
+    // Allocates the elements and the occupancy if set. Otherwise the elements live in reserved address space.
+    std::pmr::memory_resource* resource = nullptr;
 
     FreeList() = default;
 
@@ -97,11 +122,15 @@ struct FreeList
     FreeList(FreeList&& other)
     {
         capacity = other.capacity;
+        max_capacity = other.max_capacity;
 
         data = other.data;
         other.data = nullptr;
 
-        free_indices.reset(other.free_indices.release());
+        occupied = other.occupied;
+        other.occupied = nullptr;
+
+        resource = other.resource;
     }
 
     ~FreeList()
@@ -109,16 +138,13 @@ struct FreeList
         if (!data) return;
 
         // Destroy valid objects.
-        for (uint64_t i = 0; i < capacity; i++)
-        {
-            if (!free_indices[i])
-            {
-                alloc_traits::destroy(alloc, data + i);
-            }
-        }
+        for_each_live([](uint64_t, T& element) {
+            std::destroy_at(&element);
+        });
+
+        deallocate_data(data, capacity);
 
-        // Deallocate allocation.
-        alloc.deallocate(data, capacity);
+        get_occupancy_resource()->deallocate(occupied, get_word_count(capacity) * sizeof(uint64_t), alignof(uint64_t));
     }
 
     FreeList& operator = (FreeList&) = delete;
@@ -128,62 +154,86 @@ struct FreeList
         this->~FreeList();
 
         capacity = other.capacity;
+        max_capacity = other.max_capacity;
 
         data = other.data;
         other.data = nullptr;
 
-        free_indices.reset(other.free_indices.release());
+        occupied = other.occupied;
+        other.occupied = nullptr;
+
+        resource = other.resource;
 
         return *this;
     }
     
-    static std::optional<FreeList> create(uint64_t initial_capacity = 4) 
+    /**
+     * @param max_capacity The amount of elements to reserve address space for. Exceeding it moves all elements.
+     */
+    static std::optional<FreeList> create(uint64_t initial_capacity = 4, uint64_t max_capacity = DEFAULT_MAX_CAPACITY)
     {
         FreeList out;
 
-        out.capacity = initial_capacity;
+        out.max_capacity = std::max(max_capacity, initial_capacity);
 
-        out.data = out.alloc.allocate(out.capacity);
+        out.data = static_cast<T*>(platform_reserve_memory(get_byte_size(out.max_capacity)));
 
-        out.free_indices = std::make_unique<bool[]>(out.capacity);
+        if (!out.data)
+        {
+            return std::nullopt;
+        }
 
-        std::memset(out.free_indices.get(), true, out.capacity);
+        if (!out.commit(initial_capacity))
+        {
+            return std::nullopt;
+        }
 
         return out;
     }
 
-    uint64_t insert(T& element)
+    /**
+     * @brief Creates a list that allocates its elements and occupancy from a memory resource.
+     *
+     * @param resource Must outlive the list.
+     */
+    static std::optional<FreeList> create(uint64_t initial_capacity, std::pmr::memory_resource* resource)
     {
-        auto insert_idx = find_empty_index();
+        FreeList out;
 
-        if (!insert_idx.has_value())
-        {
-            grow();
-            return insert(element);
-        }
+        out.resource = resource;
+        out.max_capacity = UINT64_MAX;
 
-        alloc_traits::construct(alloc, data + *insert_idx, element);
+        out.data = static_cast<T*>(resource->allocate(initial_capacity * sizeof(T), alignof(T)));
 
-        free_indices[*insert_idx] = false;
+        out.resize_occupancy(initial_capacity);
+        out.capacity = initial_capacity;
 
-        return *insert_idx;
+        return out;
     }
 
-    uint64_t insert(T&& element)
+    /**
+     * @brief Returns the size of the pages that hold an amount of elements.
+     */
+    static uint64_t get_byte_size(uint64_t element_count)
     {
-        auto insert_idx = find_empty_index();
+        uint64_t page_size = platform_get_page_size();
 
-        if (!insert_idx.has_value())
-        {
-            grow();
-            return insert(std::forward<T>(element));
-        }
+        return (element_count * sizeof(T) + page_size - 1) / page_size * page_size;
+    }
 
-        alloc_traits::construct(alloc, data + *insert_idx, std::forward<T>(element));
+    static uint64_t get_word_count(uint64_t capacity)
+    {
+        return (capacity + 63) / 64;
+    }
 
-        free_indices[*insert_idx] = false;
+    uint64_t insert(T& element)
+    {
+        return emplace(element);
+    }
 
-        return *insert_idx;
+    uint64_t insert(T&& element)
+    {
+        return emplace(std::forward<T>(element));
     }
 
     template<typename... Args>
@@ -197,16 +247,21 @@ struct FreeList
             return emplace(std::forward<Args>(args)...);
         }
 
-        alloc_traits::construct(alloc, data + *insert_idx, std::forward<Args>(args)...);
+        std::construct_at(data + *insert_idx, std::forward<Args>(args)...);
 
-        free_indices[*insert_idx] = false;
+        occupied[*insert_idx >> 6] |= 1ull << (*insert_idx & 63);
 
         return *insert_idx;
     }
 
+    bool is_occupied(uint64_t idx) const
+    {
+        return (occupied[idx >> 6] >> (idx & 63)) & 1;
+    }
+
     std::optional<T*> get(uint64_t idx)
     {
-        if (free_indices[idx])
+        if (!is_occupied(idx))
         {
             return std::nullopt;
         }
@@ -216,49 +271,257 @@ struct FreeList
 
     void free(uint64_t idx)
     {
-        
-        if (!free_indices[idx])
+        if (is_occupied(idx))
         {
-            alloc_traits::destroy(alloc, data + idx);
+            std::destroy_at(data + idx);
         }
 
-        free_indices[idx] = true;
+        occupied[idx >> 6] &= ~(1ull << (idx & 63));
     }
 
     std::optional<uint64_t> find_empty_index()
     {
-        for (uint64_t i = 0; i < capacity; i++)
+        uint64_t word_count = get_word_count(capacity);
+
+        for (uint64_t word_idx = 0; word_idx < word_count; word_idx++)
         {
-            if (free_indices[i])
+            if (occupied[word_idx] != ~0ull)
             {
-                return i;
+                uint64_t idx = word_idx * 64 + std::countr_one(occupied[word_idx]);
+
+                // The clear bits of the last word may lie past the capacity.
+                if (idx < capacity) return idx;
             }
         }
 
         return std::nullopt;
     }
 
+    /**
+     * @brief Returns the amount of live elements.
+     */
+    uint64_t get_live_count() const
+    {
+        uint64_t count = 0;
+
+        for (uint64_t word_idx = 0; word_idx < get_word_count(capacity); word_idx++)
+        {
+            count += std::popcount(occupied[word_idx]);
+        }
+
+        return count;
+    }
+
+    /**
+     * @brief Calls `f(idx, element)` for every live element in index order, skipping empty words of the occupancy.
+     */
+    template<typename F>
+    void for_each_live(F&& f)
+    {
+        uint64_t word_count = get_word_count(capacity);
+        uint64_t word_idx = 0;
+
+        while (word_idx < word_count)
+        {
+#ifdef __AVX2__
+            // Skip four empty words at a time, which makes iterating sparse lists bandwidth bound.
+            while (word_idx + 4 <= word_count)
+            {
+                __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(occupied + word_idx));
+
+                if (!_mm256_testz_si256(words, words)) break;
+
+                word_idx += 4;
+            }
+
+            if (word_idx >= word_count) break;
+#endif
+
+            uint64_t word = occupied[word_idx];
+
+            while (word)
+            {
+                uint64_t idx = word_idx * 64 + std::countr_zero(word);
+
+                f(idx, data[idx]);
+
+                // Clear the lowest set bit.
+                word &= word - 1;
+            }
+
+            word_idx++;
+        }
+    }
+
     void grow()
     {
-        uint64_t new_capacity = capacity * 1.5f;
+        // Grow by at least half, so pages aren't committed one at a time.
+        uint64_t new_capacity = capacity + capacity / 2 + 1;
+
+        if (resource)
+        {
+            reallocate(new_capacity);
+            return;
+        }
+
+        if (new_capacity > max_capacity)
+        {
+            relocate(std::max(new_capacity, max_capacity * 2));
+            return;
+        }
+
+        // Like std::allocator, running out of memory is reported with an exception.
+        if (!commit(new_capacity))
+        {
+            throw std::bad_alloc();
+        }
+    }
 
-        T* new_data = alloc.allocate(new_capacity);
+    Iterator begin() { return Iterator(find_next_occupied(occupied, capacity, 0), capacity, data, occupied); }
+    Iterator end() { return Iterator(capacity, capacity, data, occupied); }
 
-        std::unique_ptr<bool[]> new_free_indices = std::make_unique<bool[]>(new_capacity);
+private:
+    /**
+     * @brief Commits the pages needed to hold an amount of elements, and grows the occupancy to match.
+     */
+    bool commit(uint64_t new_capacity)
+    {
+        uint64_t committed_byte_size = get_byte_size(capacity);
+        uint64_t new_committed_byte_size = get_byte_size(new_capacity);
 
-        std::memcpy(new_data, data, capacity);
-        
-        std::memset(new_free_indices.get(), true, new_capacity);
-        std::memcpy(new_free_indices.get(), free_indices.get(), capacity);
+        if (new_committed_byte_size > committed_byte_size)
+        {
+            uint8_t* start = reinterpret_cast<uint8_t*>(data) + committed_byte_size;
+
+            if (!platform_commit_memory(start, new_committed_byte_size - committed_byte_size))
+            {
+                return false;
+            }
+        }
+
+        // Use all of the committed pages.
+        new_capacity = std::min(new_committed_byte_size / sizeof(T), max_capacity);
+
+        resize_occupancy(new_capacity);
+
+        capacity = new_capacity;
+
+        return true;
+    }
+
+    /**
+     * @brief Moves all elements into a new, larger reservation. Invalidates pointers to elements.
+     */
+    void relocate(uint64_t new_max_capacity)
+    {
+        T* new_data = static_cast<T*>(platform_reserve_memory(get_byte_size(new_max_capacity)));
+
+        if (!new_data || !platform_commit_memory(new_data, get_byte_size(capacity + capacity / 2 + 1)))
+        {
+            throw std::bad_alloc();
+        }
+
+        // Move the live elements over, as T is not necessarily trivially copyable.
+        for_each_live([this, new_data](uint64_t idx, T& element) {
+            std::construct_at(new_data + idx, std::move(element));
+            std::destroy_at(&element);
+        });
+
+        platform_release_memory(data, get_byte_size(max_capacity));
+
+        data = new_data;
+        max_capacity = new_max_capacity;
+
+        uint64_t new_capacity = std::min(get_byte_size(capacity + capacity / 2 + 1) / sizeof(T), max_capacity);
 
-        alloc.deallocate(data, capacity);
+        resize_occupancy(new_capacity);
+
+        capacity = new_capacity;
+    }
+
+    /**
+     * @brief Moves all elements into a larger allocation from the memory resource.
+     */
+    void reallocate(uint64_t new_capacity)
+    {
+        T* new_data = static_cast<T*>(resource->allocate(new_capacity * sizeof(T), alignof(T)));
+
+        for_each_live([new_data](uint64_t idx, T& element) {
+            std::construct_at(new_data + idx, std::move(element));
+            std::destroy_at(&element);
+        });
+
+        deallocate_data(data, capacity);
         data = new_data;
 
+        resize_occupancy(new_capacity);
+
         capacity = new_capacity;
+    }
+
+    void deallocate_data(T* data, uint64_t capacity)
+    {
+        if (resource)
+        {
+            resource->deallocate(data, capacity * sizeof(T), alignof(T));
+        }
+        else
+        {
+            platform_release_memory(data, get_byte_size(max_capacity));
+        }
+    }
 
-        new_free_indices.reset(new_free_indices.release());
+    std::pmr::memory_resource* get_occupancy_resource() const
+    {
+        return resource ? resource : std::pmr::new_delete_resource();
     }
 
-    Iterator begin() { return Iterator(0, capacity, data, free_indices); }
-    Iterator end() { return Iterator(capacity, capacity, data, free_indices); }
+    void resize_occupancy(uint64_t new_capacity)
+    {
+        uint64_t word_count = get_word_count(capacity);
+        uint64_t new_word_count = get_word_count(new_capacity);
+
+        if (new_word_count == word_count && occupied)
+        {
+            return;
+        }
+
+        auto* new_occupied = static_cast<uint64_t*>(
+            get_occupancy_resource()->allocate(new_word_count * sizeof(uint64_t), alignof(uint64_t))
+        );
+
+        std::memset(new_occupied, 0, new_word_count * sizeof(uint64_t));
+
+        if (occupied)
+        {
+            std::memcpy(new_occupied, occupied, word_count * sizeof(uint64_t));
+
+            get_occupancy_resource()->deallocate(occupied, word_count * sizeof(uint64_t), alignof(uint64_t));
+        }
+
+        occupied = new_occupied;
+    }
+
+    /**
+     * @brief Returns the first occupied index at or after `idx`, or the capacity if there is none.
+     */
+    static uint64_t find_next_occupied(const uint64_t* occupied, uint64_t capacity, uint64_t idx)
+    {
+        uint64_t word_count = get_word_count(capacity);
+        uint64_t word_idx = idx >> 6;
+
+        if (word_idx >= word_count) return capacity;
+
+        // Only consider the bits at or above idx in the first word.
+        uint64_t word = occupied[word_idx] & (~0ull << (idx & 63));
+
+        while (!word)
+        {
+            if (++word_idx == word_count) return capacity;
+
+            word = occupied[word_idx];
+        }
+
+        return word_idx * 64 + std::countr_zero(word);
+    }
 };
@@ -0,0 +1,70 @@
+#include "container/growable_buffer_resource.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include "platform/platform.hpp"
+
+GrowableBufferResource::~GrowableBufferResource()
+{
+    if (base)
+    {
+        platform_release_memory(base, range_size * 2);
+    }
+}
+
+std::unique_ptr<GrowableBufferResource> GrowableBufferResource::create(uint64_t max_size)
+{
+    auto out = std::make_unique<GrowableBufferResource>();
+
+    uint64_t page_size = platform_get_page_size();
+
+    out->range_size = std::max((max_size + page_size - 1) / page_size * page_size, page_size);
+    out->base = static_cast<uint8_t*>(platform_reserve_memory(out->range_size * 2));
+
+    if (!out->base)
+    {
+        return nullptr;
+    }
+
+    return out;
+}
+
+void* GrowableBufferResource::do_allocate(size_t bytes, size_t)
+{
+    // Ranges start at page boundaries, which satisfies the alignment of any container element.
+    uint32_t range_idx = in_use[0] ? 1 : 0;
+
+    if (in_use[range_idx] || bytes > range_size)
+    {
+        throw std::bad_alloc();
+    }
+
+    uint64_t page_size = platform_get_page_size();
+    uint64_t committed_size = (bytes + page_size - 1) / page_size * page_size;
+
+    uint8_t* start = base + range_idx * range_size;
+
+    if (committed_size > 0 && !platform_commit_memory(start, committed_size))
+    {
+        throw std::bad_alloc();
+    }
+
+    committed_sizes[range_idx] = committed_size;
+    in_use[range_idx] = true;
+
+    return start;
+}
+
+void GrowableBufferResource::do_deallocate(void* p, size_t, size_t)
+{
+    uint32_t range_idx = static_cast<uint8_t*>(p) < base + range_size ? 0 : 1;
+
+    if (committed_sizes[range_idx] > 0)
+    {
+        platform_decommit_memory(base + range_idx * range_size, committed_sizes[range_idx]);
+    }
+
+    committed_sizes[range_idx] = 0;
+    in_use[range_idx] = false;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * @brief A memory resource for a single container that grows by reallocating, such as a std::pmr::vector.
+ *
+ * Growing a container allocates its new storage before freeing the old one, which a \ref LinearArena can't take back.
+ * This resource instead reserves two equally sized ranges of address space and places every allocation at the start of
+ * the range not in use, committing its pages. Freeing an allocation decommits its pages again, so more memory than the
+ * container holds is only committed while it moves to new storage.
+ */
+struct GrowableBufferResource : std::pmr::memory_resource
+{
+    uint8_t* base = nullptr;
+
+    // The size of each of the two ranges.
+    uint64_t range_size = 0;
+
+    // The committed size of each range, zero while the range is not in use.
+    uint64_t committed_sizes[2] = {};
+    bool in_use[2] = {};
+
+    GrowableBufferResource() = default;
+
+    GrowableBufferResource(const GrowableBufferResource&) = delete; // Prevent copies.
+
+    ~GrowableBufferResource();
+
+    GrowableBufferResource& operator = (const GrowableBufferResource&) = delete; // Prevent copies.
+
+    /**
+     * @param max_size The largest allocation to reserve address space for. Larger allocations fail with
+     * std::bad_alloc, as do allocations while both ranges are in use.
+     */
+    static std::unique_ptr<GrowableBufferResource> create(uint64_t max_size);
+
+    uint64_t get_committed_size() const { return committed_sizes[0] + committed_sizes[1]; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
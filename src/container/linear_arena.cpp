@@ -0,0 +1,103 @@
+#include "container/linear_arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+#include "platform/platform.hpp"
+
+LinearArena::~LinearArena()
+{
+    if (base)
+    {
+        platform_release_memory(base, reserve_size);
+    }
+}
+
+std::unique_ptr<LinearArena> LinearArena::create(uint64_t reserve_size)
+{
+    auto out = std::make_unique<LinearArena>();
+
+    uint64_t page_size = platform_get_page_size();
+
+    out->reserve_size = (reserve_size + page_size - 1) / page_size * page_size;
+    out->base = static_cast<uint8_t*>(platform_reserve_memory(out->reserve_size));
+
+    if (!out->base)
+    {
+        return nullptr;
+    }
+
+    return out;
+}
+
+LinearArena& LinearArena::get_thread_scratch()
+{
+    thread_local std::unique_ptr<LinearArena> scratch = create();
+
+    if (!scratch)
+    {
+        throw std::bad_alloc();
+    }
+
+    return *scratch;
+}
+
+void LinearArena::reset(uint64_t new_offset)
+{
+    offset = new_offset;
+    last_offset = new_offset;
+}
+
+void LinearArena::trim()
+{
+    uint64_t page_size = platform_get_page_size();
+    uint64_t needed_size = (offset + page_size - 1) / page_size * page_size;
+
+    if (needed_size < committed_size)
+    {
+        platform_decommit_memory(base + needed_size, committed_size - needed_size);
+
+        committed_size = needed_size;
+    }
+}
+
+void* LinearArena::do_allocate(size_t bytes, size_t alignment)
+{
+    uint64_t start = (offset + alignment - 1) & ~(static_cast<uint64_t>(alignment) - 1);
+    uint64_t end = start + bytes;
+
+    if (end > reserve_size)
+    {
+        throw std::bad_alloc();
+    }
+
+    if (end > committed_size)
+    {
+        // Commit at least a quarter of what is already committed, so pages aren't committed one at a time.
+        uint64_t page_size = platform_get_page_size();
+        uint64_t new_committed_size = std::max(end, committed_size + committed_size / 4);
+
+        new_committed_size = std::min((new_committed_size + page_size - 1) / page_size * page_size, reserve_size);
+
+        if (!platform_commit_memory(base + committed_size, new_committed_size - committed_size))
+        {
+            throw std::bad_alloc();
+        }
+
+        committed_size = new_committed_size;
+    }
+
+    last_offset = offset;
+    offset = end;
+
+    return base + start;
+}
+
+void LinearArena::do_deallocate(void* p, size_t bytes, size_t)
+{
+    // Roll back the most recent allocation.
+    if (static_cast<uint8_t*>(p) + bytes == base + offset && offset != last_offset)
+    {
+        offset = last_offset;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * @brief A memory resource that allocates by bumping an offset into a reserved range of address space.
+ *
+ * Pages are committed as the offset grows. Individual deallocations are ignored, except for the most recent allocation,
+ * which is rolled back so that growing the last allocated container doesn't waste memory. All memory is released at
+ * once by \ref reset or by destroying the arena.
+ */
+struct LinearArena : std::pmr::memory_resource
+{
+    static constexpr uint64_t DEFAULT_RESERVE_SIZE = 256ull * 1024 * 1024;
+
+    uint8_t* base = nullptr;
+    uint64_t reserve_size = 0;
+    uint64_t committed_size = 0;
+    uint64_t offset = 0;
+
+    // The offset before the most recent allocation.
+    uint64_t last_offset = 0;
+
+    LinearArena() = default;
+
+    LinearArena(const LinearArena&) = delete; // Prevent copies.
+
+    ~LinearArena();
+
+    LinearArena& operator = (const LinearArena&) = delete; // Prevent copies.
+
+    /**
+     * @param reserve_size The amount of address space to reserve. Allocations beyond it fail with std::bad_alloc.
+     */
+    static std::unique_ptr<LinearArena> create(uint64_t reserve_size = DEFAULT_RESERVE_SIZE);
+
+    /**
+     * @brief Returns an arena for short-lived scratch allocations that is private to the calling thread.
+     *
+     * Use a \ref LinearArenaScope to release the scratch allocations once done.
+     */
+    static LinearArena& get_thread_scratch();
+
+    /**
+     * @brief Releases every allocation made after the offset was `new_offset`. Committed pages are kept for reuse.
+     */
+    void reset(uint64_t new_offset = 0);
+
+    /**
+     * @brief Returns committed pages beyond the current offset to the system.
+     */
+    void trim();
+
+    uint64_t get_used_size() const { return offset; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+/**
+ * @brief Releases the allocations made from an arena during its lifetime.
+ */
+struct LinearArenaScope
+{
+    LinearArena& arena;
+    uint64_t offset;
+
+    explicit LinearArenaScope(LinearArena& arena) : arena {arena}, offset {arena.get_used_size()} {}
+
+    LinearArenaScope(const LinearArenaScope&) = delete; // Prevent copies.
+
+    ~LinearArenaScope() { arena.reset(offset); }
+
+    LinearArenaScope& operator = (const LinearArenaScope&) = delete; // Prevent copies.
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/**
+ * @brief A bounded, lock-free queue with any amount of producer threads and a single consumer thread.
+ *
+ * Every cell carries a sequence number that tells producers and the consumer whose turn it is, as in Dmitry Vyukov's
+ * bounded queue. Producers claim a position with a single compare-and-swap. Neither pushing nor popping allocates.
+ */
+template<typename T>
+struct MpscQueue
+{
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    uint64_t mask;
+
+    // Kept on separate cache lines, as producers and the consumer update them concurrently.
+    alignas(64) std::atomic<uint64_t> enqueue_position;
+    alignas(64) uint64_t dequeue_position;
+
+    MpscQueue() = default;
+
+    MpscQueue(const MpscQueue&) = delete; // Prevent copies.
+
+    MpscQueue& operator = (const MpscQueue&) = delete; // Prevent copies.
+
+    /**
+     * @param capacity The maximum amount of queued elements. Rounded up to a power of two.
+     */
+    static std::unique_ptr<MpscQueue> create(uint64_t capacity)
+    {
+        auto out = std::make_unique<MpscQueue>();
+
+        capacity = std::bit_ceil(std::max<uint64_t>(capacity, 2));
+
+        out->cells = std::make_unique<Cell[]>(capacity);
+        out->mask = capacity - 1;
+
+        for (uint64_t i = 0; i < capacity; i++)
+        {
+            out->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        out->enqueue_position.store(0, std::memory_order_relaxed);
+        out->dequeue_position = 0;
+
+        return out;
+    }
+
+    /**
+     * @brief Pushes an element. Safe to call from any thread.
+     *
+     * @return false if the queue is full.
+     */
+    bool try_push(const T& value)
+    {
+        uint64_t position = enqueue_position.load(std::memory_order_relaxed);
+        Cell* cell;
+
+        while (true)
+        {
+            cell = &cells[position & mask];
+
+            uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int64_t difference = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+
+            if (difference == 0)
+            {
+                // The cell is free, try to claim it.
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The consumer hasn't freed the cell yet, so the queue is full.
+                return false;
+            }
+            else
+            {
+                // Another producer claimed the cell.
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+
+        // Publish the element to the consumer.
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * @brief Pops the oldest element. Must only be called from the consumer thread.
+     *
+     * @return std::nullopt if the queue is empty, or the oldest element is still being pushed.
+     */
+    std::optional<T> try_pop()
+    {
+        Cell& cell = cells[dequeue_position & mask];
+
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+        {
+            return std::nullopt;
+        }
+
+        T value = std::move(cell.value);
+
+        // Hand the cell back to producers for the next lap.
+        cell.sequence.store(dequeue_position + mask + 1, std::memory_order_release);
+
+        dequeue_position++;
+
+        return value;
+    }
+
+    /**
+     * @brief Returns the amount of elements pushed but not yet popped, including ones still being pushed. Must only
+     * be called from the consumer thread.
+     */
+    uint64_t get_size() const
+    {
+        return enqueue_position.load(std::memory_order_acquire) - dequeue_position;
+    }
+};
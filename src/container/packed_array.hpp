@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * @brief A resizable array of unsigned integers that are stored using a fixed amount of bits per element.
+ *
+ * The element width is always a power of two between 1 and 32 bits, so an element never straddles two 64-bit words.
+ * The width can be increased at any time, in which case all stored elements are repacked.
+ */
+struct PackedArray
+{
+    uint8_t width = 1;
+    uint64_t size = 0;
+
+    std::pmr::vector<uint64_t> words;
+
+    PackedArray() = default;
+
+    explicit PackedArray(uint8_t width, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : width {width}, words {resource} {}
+
+    static uint64_t get_word_count(uint64_t size, uint8_t width)
+    {
+        return (size * width + 63) / 64;
+    }
+
+    /**
+     * @brief Reads an element from packed words that are not owned by a PackedArray, e.g. a memory mapped file.
+     */
+    static uint32_t read(const uint64_t* words, uint8_t width, uint64_t idx)
+    {
+        uint64_t bit = idx * width;
+        uint64_t mask = (1ull << width) - 1;
+
+        return (words[bit >> 6] >> (bit & 63)) & mask;
+    }
+
+    uint32_t get(uint64_t idx) const
+    {
+        return read(words.data(), width, idx);
+    }
+
+    void set(uint64_t idx, uint32_t value)
+    {
+        uint64_t bit = idx * width;
+        uint64_t mask = (1ull << width) - 1;
+
+        uint64_t& word = words[bit >> 6];
+
+        word = (word & ~(mask << (bit & 63))) | ((value & mask) << (bit & 63));
+    }
+
+    void resize(uint64_t new_size)
+    {
+        // Resize the words first, so the array stays unchanged if that throws.
+        words.resize(get_word_count(new_size, width), 0);
+
+        size = new_size;
+    }
+
+    /**
+     * @brief Repacks all elements to a new element width.
+     *
+     * @param new_width The new width in bits. Must be a power of two not larger than 32, and large enough to hold every
+     * stored value.
+     */
+    void set_width(uint8_t new_width)
+    {
+        if (new_width == width) return;
+
+        PackedArray out(new_width, words.get_allocator().resource());
+        out.resize(size);
+
+        for (uint64_t i = 0; i < size; i++)
+        {
+            out.set(i, get(i));
+        }
+
+        *this = std::move(out);
+    }
+
+    uint64_t get_byte_size() const
+    {
+        return words.size() * sizeof(uint64_t);
+    }
+};
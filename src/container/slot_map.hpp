@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Refers to an element of a \ref SlotMap. Stays invalid once the element is removed, even if its slot is reused.
+ */
+struct SlotMapHandle
+{
+    uint32_t index;
+    uint32_t generation; // Always odd for handles to live elements, so a zeroed handle is never valid.
+
+    friend bool operator == (const SlotMapHandle& a, const SlotMapHandle& b) = default;
+};
+
+/**
+ * @brief A container handing out generational handles to its elements.
+ *
+ * Every slot stores a generation that is incremented whenever its element is inserted or removed, so the generation of
+ * a slot is odd while it is occupied. A handle is valid as long as its generation matches the one of its slot.
+ *
+ * The elements themselves are stored contiguously and are moved when another element is removed, so iteration only
+ * touches live elements. Slots map handles to dense indices, and `dense_slots` maps dense indices back to slots.
+ */
+template<typename T>
+struct SlotMap
+{
+    struct Slot
+    {
+        uint32_t generation;
+        uint32_t index; // The dense index while occupied, the next free slot otherwise.
+    };
+
+    static constexpr uint32_t NO_FREE_SLOT = UINT32_MAX;
+
+    std::vector<Slot> slots;
+
+    std::vector<T> values;
+    std::vector<uint32_t> dense_slots;
+
+    uint32_t free_head = NO_FREE_SLOT;
+
+    SlotMap() = default;
+
+    SlotMapHandle insert(const T& element)
+    {
+        return emplace(element);
+    }
+
+    SlotMapHandle insert(T&& element)
+    {
+        return emplace(std::move(element));
+    }
+
+    template<typename... Args>
+    SlotMapHandle emplace(Args&&... args)
+    {
+        uint32_t slot_idx;
+
+        if (free_head != NO_FREE_SLOT)
+        {
+            slot_idx = free_head;
+            free_head = slots[slot_idx].index;
+        }
+        else
+        {
+            slot_idx = slots.size();
+            slots.push_back(Slot { 0, 0 });
+        }
+
+        values.emplace_back(std::forward<Args>(args)...);
+        dense_slots.push_back(slot_idx);
+
+        Slot& slot = slots[slot_idx];
+        slot.generation++;
+        slot.index = values.size() - 1;
+
+        return SlotMapHandle { slot_idx, slot.generation };
+    }
+
+    bool contains(SlotMapHandle handle) const
+    {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation;
+    }
+
+    std::optional<T*> get(SlotMapHandle handle)
+    {
+        if (!contains(handle))
+        {
+            return std::nullopt;
+        }
+
+        return &values[slots[handle.index].index];
+    }
+
+    std::optional<const T*> get(SlotMapHandle handle) const
+    {
+        if (!contains(handle))
+        {
+            return std::nullopt;
+        }
+
+        return &values[slots[handle.index].index];
+    }
+
+    /**
+     * @brief Removes an element. The last element is moved into its place.
+     *
+     * @return false if the handle was already invalid.
+     */
+    bool remove(SlotMapHandle handle)
+    {
+        if (!contains(handle))
+        {
+            return false;
+        }
+
+        Slot& slot = slots[handle.index];
+        uint32_t dense_idx = slot.index;
+
+        if (dense_idx != values.size() - 1)
+        {
+            values[dense_idx] = std::move(values.back());
+            dense_slots[dense_idx] = dense_slots.back();
+
+            slots[dense_slots[dense_idx]].index = dense_idx;
+        }
+
+        values.pop_back();
+        dense_slots.pop_back();
+
+        slot.generation++;
+
+        // Retire slots whose generation is about to wrap around, so old handles can never become valid again.
+        if (slot.generation != UINT32_MAX - 1)
+        {
+            slot.index = free_head;
+            free_head = handle.index;
+        }
+
+        return true;
+    }
+
+    void clear()
+    {
+        for (uint32_t dense_idx = values.size(); dense_idx > 0; dense_idx--)
+        {
+            uint32_t slot_idx = dense_slots[dense_idx - 1];
+
+            remove(SlotMapHandle { slot_idx, slots[slot_idx].generation });
+        }
+    }
+
+    /**
+     * @brief Returns the handle of the element at a dense index, in the range [0, size()).
+     */
+    SlotMapHandle get_handle(uint64_t dense_idx) const
+    {
+        uint32_t slot_idx = dense_slots[dense_idx];
+
+        return SlotMapHandle { slot_idx, slots[slot_idx].generation };
+    }
+
+    uint64_t size() const { return values.size(); }
+
+    bool empty() const { return values.empty(); }
+
+    T* begin() { return values.data(); }
+    T* end() { return values.data() + values.size(); }
+
+    const T* begin() const { return values.data(); }
+    const T* end() const { return values.data() + values.size(); }
+};
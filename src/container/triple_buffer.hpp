@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Hands the latest value from a writer thread to a reader thread without either ever blocking.
+ *
+ * The writer and reader each own a buffer, and the third buffer sits in between. Publishing swaps the write buffer with
+ * the middle one, and the reader swaps its buffer with the middle one whenever a newer value was published, so the
+ * reader always sees the most recently published value and values it missed are skipped.
+ *
+ * After publishing, the write buffer holds an older value. Writers must overwrite it completely before publishing again.
+ */
+template<typename T>
+struct TripleBuffer
+{
+    static constexpr uint8_t INDEX_MASK = 3;
+
+    // Set in `middle` when it holds a value the reader has not taken yet.
+    static constexpr uint8_t FRESH_BIT = 4;
+
+    // Each buffer gets its own cache lines, as the writer and reader access theirs concurrently.
+    struct alignas(64) Buffer
+    {
+        T value;
+    };
+
+    std::array<Buffer, 3> buffers;
+
+    uint8_t write_index = 0;
+
+    alignas(64) std::atomic<uint8_t> middle { 1 };
+
+    alignas(64) uint8_t read_index = 2;
+
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete; // Prevent copies.
+
+    TripleBuffer& operator = (const TripleBuffer&) = delete; // Prevent copies.
+
+    /**
+     * @brief Returns the buffer the writer fills before calling \ref publish. Only call from the writer thread.
+     */
+    T& get_write_buffer() { return buffers[write_index].value; }
+
+    /**
+     * @brief Makes the write buffer available to the reader. Only call from the writer thread.
+     */
+    void publish()
+    {
+        write_index = middle.exchange(write_index | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /**
+     * @brief Takes the most recently published value, if it wasn't taken yet. Only call from the reader thread.
+     *
+     * @return false if nothing was published since the last update, in which case the read buffer is unchanged.
+     */
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+        {
+            return false;
+        }
+
+        read_index = middle.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+
+        return true;
+    }
+
+    /**
+     * @brief Returns the value taken by the last \ref update. Only call from the reader thread.
+     */
+    const T& get_read_buffer() const { return buffers[read_index].value; }
+};
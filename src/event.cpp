@@ -1,17 +1,81 @@
 #include "event.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include <simple-logger.hpp>
 
+#include "container/mpsc_queue.hpp"
+#include "platform/platform.hpp"
+
+// The amount of events other threads can post between two flushes.
+#define POSTED_EVENT_CAPACITY 4096
+
+struct EventListener
+{
+	// Exactly one of the callbacks is set, or neither once the listener was removed while its event is firing.
+	on_event_cb callback;
+	on_event_user_cb user_callback;
+	void* user_data;
+
+	bool operator == (const EventListener&) const = default;
+};
+
 struct EventEntry
+{
+	bool registered;
+
+	// Listeners removed while the event is being fired are cleared, and erased once firing is done.
+	std::vector<EventListener> listeners;
+	uint32_t firing_depth;
+	bool has_removed_listeners;
+
+	EventDispatchMode dispatch_mode;
+
+	// The sequence number of the queued event of this code, used to coalesce events.
+	bool has_queued_event;
+	uint64_t queued_sequence;
+};
+
+struct QueuedEvent
 {
 	uint16_t event_code;
-	std::vector<on_event_cb> listeners;
+	EventContext ctx;
 };
 
-static std::vector<EventEntry> registered_events;
-static bool initialized = false;
+/**
+ * @brief A ring of queued events that grows when full. An event with sequence number `s` is stored at
+ * `s & (events.size() - 1)`.
+ */
+struct EventQueue
+{
+	std::vector<QueuedEvent> events;
+
+	uint64_t head_sequence;
+	uint64_t tail_sequence;
+};
+
+// Indexed by event code.
+static std::vector<EventEntry> event_table;
+static EventQueue event_queue;
+static std::unique_ptr<MpscQueue<QueuedEvent>> posted_events;
+
+// Whether events were posted since the last flush, and so the main thread was already woken.
+static std::atomic<bool> posted_events_wake_pending;
+
+// Checked by posting threads, which may outlive the subsystem.
+static std::atomic<bool> initialized = false;
+
+static EventEntry* get_registered_entry(uint16_t event_code);
+
+static void dispatch_event(uint16_t event_code, EventContext ctx);
+
+static void queue_event(EventEntry& entry, uint16_t event_code, EventContext ctx);
+
+static void add_listener(uint16_t event_code, EventListener listener);
+
+static void remove_listener(uint16_t event_code, EventListener listener);
 
 bool event_init()
 {
@@ -20,51 +84,265 @@ bool event_init()
 		event_register(i);
 	}
 
+	posted_events = MpscQueue<QueuedEvent>::create(POSTED_EVENT_CAPACITY);
+
 	sl::log_info("Successfully initialized the event subsystem.");
 
-	initialized = true;
+	initialized.store(true, std::memory_order_release);
 
 	return true;
 }
 
 void event_shutdown()
 {
+	initialized.store(false, std::memory_order_release);
+
+	event_table.clear();
+	event_queue = {};
+	posted_events.reset();
+
 	sl::log_info("Successfully shut down the event system.");
 }
 
 void event_register(uint16_t event_code)
 {
-	EventEntry entry = {};
-	entry.event_code = event_code;
+	if (event_code >= event_table.size())
+	{
+		event_table.resize(event_code + 1);
+	}
 
-	registered_events.push_back(entry);
+	event_table[event_code].registered = true;
 }
 
 void event_fire(uint16_t event_code, EventContext ctx)
 {
-	for (auto& entry : registered_events)
+	if (event_code >= event_table.size())
+	{
+		return;
+	}
+
+	EventEntry& entry = event_table[event_code];
+
+	if (entry.dispatch_mode == EventDispatchMode::EVENT_DISPATCH_IMMEDIATE)
+	{
+		dispatch_event(event_code, ctx);
+	}
+	else
+	{
+		queue_event(entry, event_code, ctx);
+	}
+}
+
+void event_set_dispatch_mode(uint16_t event_code, EventDispatchMode mode)
+{
+	EventEntry* entry = get_registered_entry(event_code);
+
+	if (!entry)
+	{
+		sl::log_warn("Tried to set the dispatch mode of the unregistered event code {}.", event_code);
+		return;
+	}
+
+	entry->dispatch_mode = mode;
+}
+
+bool event_post(uint16_t event_code, EventContext ctx)
+{
+	if (!initialized.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	if (!posted_events->try_push(QueuedEvent { event_code, ctx }))
 	{
-		if (entry.event_code == event_code)
+		return false;
+	}
+
+	// Wake the main thread in case it is waiting for messages. Only the first post since the last flush has to.
+	if (!posted_events_wake_pending.exchange(true, std::memory_order_acq_rel))
+	{
+		platform_wake();
+	}
+
+	return true;
+}
+
+void event_flush()
+{
+	posted_events_wake_pending.store(false, std::memory_order_release);
+
+	// Fire the events posted by other threads first, so queued ones among them are dispatched by this flush. Only the
+	// events posted so far are fired, so threads posting continuously can't keep the flush going.
+	uint64_t posted_count = posted_events->get_size();
+
+	for (uint64_t i = 0; i < posted_count; i++)
+	{
+		auto event = posted_events->try_pop();
+
+		if (!event.has_value())
 		{
-			for (auto& event_cb : entry.listeners)
-			{
-				(*event_cb)(event_code, ctx);
-			}
+			break;
+		}
+
+		event_fire(event->event_code, event->ctx);
+	}
+
+	// Only dispatch the events queued so far, so listeners queueing events can't keep the flush going.
+	uint64_t end_sequence = event_queue.tail_sequence;
+
+	while (event_queue.head_sequence != end_sequence)
+	{
+		uint64_t sequence = event_queue.head_sequence++;
+
+		// Copied, as listeners may queue events and grow the queue.
+		QueuedEvent event = event_queue.events[sequence & (event_queue.events.size() - 1)];
+
+		EventEntry& entry = event_table[event.event_code];
 
-			return;
+		if (entry.has_queued_event && entry.queued_sequence == sequence)
+		{
+			entry.has_queued_event = false;
 		}
+
+		dispatch_event(event.event_code, event.ctx);
 	}
 }
 
 void event_add_listener(uint16_t event_code, on_event_cb listener)
 {
-	for (auto& entry : registered_events)
+	add_listener(event_code, EventListener { listener, nullptr, nullptr });
+}
+
+void event_add_listener(uint16_t event_code, on_event_user_cb listener, void* user_data)
+{
+	add_listener(event_code, EventListener { nullptr, listener, user_data });
+}
+
+void event_remove_listener(uint16_t event_code, on_event_cb listener)
+{
+	remove_listener(event_code, EventListener { listener, nullptr, nullptr });
+}
+
+void event_remove_listener(uint16_t event_code, on_event_user_cb listener, void* user_data)
+{
+	remove_listener(event_code, EventListener { nullptr, listener, user_data });
+}
+
+static EventEntry* get_registered_entry(uint16_t event_code)
+{
+	if (event_code >= event_table.size() || !event_table[event_code].registered)
 	{
-		if (entry.event_code == event_code)
+		return nullptr;
+	}
+
+	return &event_table[event_code];
+}
+
+static void dispatch_event(uint16_t event_code, EventContext ctx)
+{
+	event_table[event_code].firing_depth++;
+
+	// Listeners may add listeners or register events while firing, which can reallocate the table and listener
+	// arrays, so neither is held on to across invocations.
+	for (size_t i = 0; i < event_table[event_code].listeners.size(); i++)
+	{
+		EventListener listener = event_table[event_code].listeners[i];
+
+		if (listener.callback)
 		{
-			entry.listeners.push_back(listener);
+			listener.callback(event_code, ctx);
+		}
+		else if (listener.user_callback)
+		{
+			listener.user_callback(event_code, ctx, listener.user_data);
+		}
+	}
+
+	EventEntry& entry = event_table[event_code];
 
-			return;
+	entry.firing_depth--;
+
+	if (entry.firing_depth == 0 && entry.has_removed_listeners)
+	{
+		std::erase_if(entry.listeners, [](const EventListener& listener) {
+			return listener.callback == nullptr && listener.user_callback == nullptr;
+		});
+
+		entry.has_removed_listeners = false;
+	}
+}
+
+
+static void queue_event(EventEntry& entry, uint16_t event_code, EventContext ctx)
+{
+	if (entry.dispatch_mode == EventDispatchMode::EVENT_DISPATCH_COALESCED && entry.has_queued_event)
+	{
+		// Keep the position of the queued event, but replace its context with the latest one.
+		event_queue.events[entry.queued_sequence & (event_queue.events.size() - 1)].ctx = ctx;
+		return;
+	}
+
+	uint64_t capacity = event_queue.events.size();
+
+	if (event_queue.tail_sequence - event_queue.head_sequence == capacity)
+	{
+		// Double the ring, keeping every event at the slot its sequence number maps to.
+		uint64_t new_capacity = std::max<uint64_t>(capacity * 2, 256);
+
+		std::vector<QueuedEvent> events(new_capacity);
+
+		for (uint64_t sequence = event_queue.head_sequence; sequence != event_queue.tail_sequence; sequence++)
+		{
+			events[sequence & (new_capacity - 1)] = event_queue.events[sequence & (capacity - 1)];
 		}
+
+		event_queue.events = std::move(events);
+	}
+
+	uint64_t sequence = event_queue.tail_sequence++;
+
+	event_queue.events[sequence & (event_queue.events.size() - 1)] = QueuedEvent { event_code, ctx };
+
+	entry.has_queued_event = true;
+	entry.queued_sequence = sequence;
+}
+
+static void add_listener(uint16_t event_code, EventListener listener)
+{
+	EventEntry* entry = get_registered_entry(event_code);
+
+	if (!entry)
+	{
+		sl::log_warn("Tried to add a listener to the unregistered event code {}.", event_code);
+		return;
+	}
+
+	entry->listeners.push_back(listener);
+}
+
+static void remove_listener(uint16_t event_code, EventListener listener)
+{
+	EventEntry* entry = get_registered_entry(event_code);
+
+	if (!entry)
+	{
+		return;
+	}
+
+	auto it = std::find(entry->listeners.begin(), entry->listeners.end(), listener);
+
+	if (it == entry->listeners.end())
+	{
+		return;
+	}
+
+	if (entry->firing_depth > 0)
+	{
+		*it = EventListener {};
+		entry->has_removed_listeners = true;
+	}
+	else
+	{
+		entry->listeners.erase(it);
 	}
 }
@@ -8,7 +8,7 @@
 enum EventCodes
 {
 	/**
-	 * @brief Called when the game window should close.
+	 * @brief Called when the game window should close, or when a headless process is interrupted or terminated.
 	 * 
 	 * Provides an empty event context.
 	 */
@@ -70,6 +70,28 @@ enum EventCodes
 	MAX_ENUM
 };
 
+/**
+ * @brief How fired events reach their listeners.
+ */
+enum EventDispatchMode
+{
+	/**
+	 * @brief Listeners are invoked from within \ref event_fire. The default.
+	 */
+	EVENT_DISPATCH_IMMEDIATE,
+
+	/**
+	 * @brief Events are queued and dispatched in order by \ref event_flush.
+	 */
+	EVENT_DISPATCH_QUEUED,
+
+	/**
+	 * @brief Like \ref EVENT_DISPATCH_QUEUED, but an event fired while another of the same code is still queued
+	 * replaces its context. Suited for events where only the latest state matters, like mouse moves.
+	 */
+	EVENT_DISPATCH_COALESCED
+};
+
 /**
  * @brief The context of an event.
  * 
@@ -119,6 +141,15 @@ struct EventContext
  */
 typedef void (*on_event_cb)(uint16_t event_code, EventContext ctx);
 
+/**
+ * @brief An event callback that receives the user pointer it was registered with.
+ * 
+ * @param event_code The event code.
+ * @param ctx The passed event context.
+ * @param user_data The pointer passed to \ref event_add_listener.
+ */
+typedef void (*on_event_user_cb)(uint16_t event_code, EventContext ctx, void* user_data);
+
 /**
  * @brief Initializes the event subsystem.
  * 
@@ -151,6 +182,34 @@ void event_register(uint16_t event_code);
  */
 void event_fire(uint16_t event_code, EventContext ctx);
 
+/**
+ * @brief Posts an event from any thread. It is fired on the main thread by the next \ref event_flush.
+ * 
+ * Posting is lock-free and doesn't allocate, but fails if too many posted events are waiting, or if the event
+ * subsystem is not initialized. Threads that post must be stopped before \ref event_shutdown.
+ * 
+ * @param event_code The event code to fire.
+ * @param ctx The ctx that gets passed to all listeners.
+ * 
+ * @return false if the event could not be posted.
+ */
+bool event_post(uint16_t event_code, EventContext ctx);
+
+/**
+ * @brief Sets how events of a code are dispatched.
+ * 
+ * @param event_code The event code. Must be registered.
+ * @param mode The dispatch mode.
+ */
+void event_set_dispatch_mode(uint16_t event_code, EventDispatchMode mode);
+
+/**
+ * @brief Fires the posted events, then dispatches all queued events in the order they were fired.
+ * 
+ * Events that get queued by listeners during the flush are dispatched by the next flush.
+ */
+void event_flush();
+
 /**
  * @brief Adds a listener to an event.
  * 
@@ -158,3 +217,29 @@ void event_fire(uint16_t event_code, EventContext ctx);
  * @param listener The listener to add.
  */
 void event_add_listener(uint16_t event_code, on_event_cb listener);
+
+/**
+ * @brief Adds a listener that receives a user pointer to an event.
+ * 
+ * @param event_code The event code to add a listener to.
+ * @param listener The listener to add.
+ * @param user_data The pointer passed to every invocation of the listener.
+ */
+void event_add_listener(uint16_t event_code, on_event_user_cb listener, void* user_data);
+
+/**
+ * @brief Removes a listener from an event. Listeners may remove themselves while being invoked.
+ * 
+ * @param event_code The event code to remove the listener from.
+ * @param listener The listener to remove.
+ */
+void event_remove_listener(uint16_t event_code, on_event_cb listener);
+
+/**
+ * @brief Removes a listener that was added together with a user pointer.
+ * 
+ * @param event_code The event code to remove the listener from.
+ * @param listener The listener to remove.
+ * @param user_data The user pointer the listener was added with.
+ */
+void event_remove_listener(uint16_t event_code, on_event_user_cb listener, void* user_data);
@@ -0,0 +1,315 @@
+#include "frame_stats.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+
+#include <simple-logger.hpp>
+
+// The amount of frames kept for the windows. Must be a power of two. Windows lose their oldest frames early if they
+// hold more frames than this, which only happens above ~3000 fps.
+#define FRAME_STATS_SAMPLE_CAPACITY (1 << 15)
+
+static constexpr size_t METRIC_COUNT = (size_t) FrameStatsMetric::MAX_ENUM;
+static constexpr size_t WINDOW_COUNT = (size_t) FrameStatsWindow::MAX_ENUM;
+
+static constexpr uint64_t WINDOW_DURATIONS[WINDOW_COUNT] = {
+	1'000'000'000,
+	10'000'000'000
+};
+
+struct FrameStatsSample
+{
+	uint64_t time_ns;
+	std::array<uint64_t, METRIC_COUNT> timings;
+	bool is_hitch;
+};
+
+struct FrameStatsWindowState
+{
+	// The sequence number of the oldest sample within the window.
+	uint64_t first;
+
+	std::array<FrameTimeHistogram, METRIC_COUNT> histograms;
+
+	uint64_t hitch_count;
+};
+
+static void add_sample(FrameStatsWindowState& window, const FrameStatsSample& sample);
+static void remove_sample(FrameStatsWindowState& window, const FrameStatsSample& sample);
+static void log_summary();
+
+static struct
+{
+	// A ring of the most recent samples, indexed by sequence number.
+	std::unique_ptr<FrameStatsSample[]> samples;
+
+	// The sequence number of the next sample.
+	uint64_t next;
+
+	std::unique_ptr<FrameStatsWindowState[]> windows;
+
+	uint64_t total_hitch_count;
+	uint64_t hitch_threshold = 50'000'000;
+
+	uint64_t log_interval = 1'000'000'000;
+	uint64_t last_log_time;
+} frame_stats_state;
+
+void FrameTimeHistogram::add(uint64_t ns)
+{
+	counts[get_bucket_index(ns)]++;
+	sample_count++;
+}
+
+void FrameTimeHistogram::remove(uint64_t ns)
+{
+	counts[get_bucket_index(ns)]--;
+	sample_count--;
+}
+
+uint64_t FrameTimeHistogram::get_percentile(double percentile) const
+{
+	if (sample_count == 0)
+	{
+		return 0;
+	}
+
+	// The rank of the sample at the percentile, starting at 1.
+	uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * sample_count));
+	rank = std::clamp<uint64_t>(rank, 1, sample_count);
+
+	uint64_t seen = 0;
+
+	for (uint32_t i = 0; i < BUCKET_COUNT; i++)
+	{
+		seen += counts[i];
+
+		if (seen >= rank)
+		{
+			return get_bucket_upper_bound(i);
+		}
+	}
+
+	return get_bucket_upper_bound(BUCKET_COUNT - 1);
+}
+
+uint32_t FrameTimeHistogram::get_bucket_index(uint64_t ns)
+{
+	if (ns < SUB_BUCKET_COUNT)
+	{
+		return static_cast<uint32_t>(ns);
+	}
+
+	// The index of the highest set bit, and the SUB_BUCKET_BITS bits below it.
+	uint32_t exponent = std::bit_width(ns) - 1;
+	uint32_t mantissa = static_cast<uint32_t>(ns >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1);
+
+	return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + mantissa;
+}
+
+uint64_t FrameTimeHistogram::get_bucket_upper_bound(uint32_t bucket_idx)
+{
+	if (bucket_idx < SUB_BUCKET_COUNT)
+	{
+		return bucket_idx;
+	}
+
+	uint32_t exponent = bucket_idx / SUB_BUCKET_COUNT + SUB_BUCKET_BITS - 1;
+	uint64_t mantissa = bucket_idx % SUB_BUCKET_COUNT;
+
+	uint32_t shift = exponent - SUB_BUCKET_BITS;
+
+	// The lower bound of the next bucket, minus one. Written so the last bucket doesn't overflow.
+	return ((SUB_BUCKET_COUNT + mantissa) << shift) + ((uint64_t(1) << shift) - 1);
+}
+
+bool frame_stats_init()
+{
+	frame_stats_state.samples.reset(new (std::nothrow) FrameStatsSample[FRAME_STATS_SAMPLE_CAPACITY]);
+	frame_stats_state.windows.reset(new (std::nothrow) FrameStatsWindowState[WINDOW_COUNT]());
+
+	if (!frame_stats_state.samples || !frame_stats_state.windows)
+	{
+		sl::log_error("Failed to allocate the frame statistics.");
+		return false;
+	}
+
+	frame_stats_state.next = 0;
+	frame_stats_state.total_hitch_count = 0;
+	frame_stats_state.last_log_time = 0;
+
+	sl::log_info("Successfully initialized the frame statistics.");
+
+	return true;
+}
+
+void frame_stats_shutdown()
+{
+	frame_stats_state.samples.reset();
+	frame_stats_state.windows.reset();
+
+	sl::log_info("Successfully shut down the frame statistics.");
+}
+
+void frame_stats_record(uint64_t time_ns, const std::array<uint64_t, METRIC_COUNT>& timings)
+{
+	auto& samples = frame_stats_state.samples;
+	auto& windows = frame_stats_state.windows;
+
+	uint64_t seq = frame_stats_state.next++;
+
+	// Make room in the ring by dropping the oldest sample from the windows that still hold it.
+	for (size_t i = 0; i < WINDOW_COUNT; i++)
+	{
+		if (seq - windows[i].first == FRAME_STATS_SAMPLE_CAPACITY)
+		{
+			remove_sample(windows[i], samples[windows[i].first++ & (FRAME_STATS_SAMPLE_CAPACITY - 1)]);
+		}
+	}
+
+	FrameStatsSample& sample = samples[seq & (FRAME_STATS_SAMPLE_CAPACITY - 1)];
+	sample.time_ns = time_ns;
+	sample.timings = timings;
+
+	uint64_t frame_time = timings[(size_t) FrameStatsMetric::FRAME];
+	sample.is_hitch = frame_time != FRAME_STATS_NO_SAMPLE && frame_time > frame_stats_state.hitch_threshold;
+
+	if (sample.is_hitch)
+	{
+		frame_stats_state.total_hitch_count++;
+	}
+
+	// Add the sample, and age the samples that fell out of each window.
+	for (size_t i = 0; i < WINDOW_COUNT; i++)
+	{
+		add_sample(windows[i], sample);
+
+		while (windows[i].first != seq)
+		{
+			const FrameStatsSample& oldest = samples[windows[i].first & (FRAME_STATS_SAMPLE_CAPACITY - 1)];
+
+			if (time_ns - oldest.time_ns < WINDOW_DURATIONS[i]) break;
+
+			remove_sample(windows[i], oldest);
+			windows[i].first++;
+		}
+	}
+
+	if (seq == 0)
+	{
+		// Start the first log interval at the first frame, so the first log covers a full window.
+		frame_stats_state.last_log_time = time_ns;
+	}
+	else if (frame_stats_state.log_interval != 0 &&
+		time_ns - frame_stats_state.last_log_time >= frame_stats_state.log_interval)
+	{
+		log_summary();
+
+		frame_stats_state.last_log_time = time_ns;
+	}
+}
+
+FrameStatsSummary frame_stats_get_summary(FrameStatsWindow window, FrameStatsMetric metric)
+{
+	const FrameStatsWindowState& state = frame_stats_state.windows[(size_t) window];
+	const FrameTimeHistogram& histogram = state.histograms[(size_t) metric];
+
+	FrameStatsSummary summary;
+	summary.sample_count = histogram.sample_count;
+	summary.p50 = histogram.get_percentile(50.0);
+	summary.p95 = histogram.get_percentile(95.0);
+	summary.p99 = histogram.get_percentile(99.0);
+	summary.p999 = histogram.get_percentile(99.9);
+	summary.max = 0;
+
+	// The histogram only knows buckets, so find the exact maximum among the samples.
+	for (uint64_t seq = state.first; seq != frame_stats_state.next; seq++)
+	{
+		uint64_t timing = frame_stats_state.samples[seq & (FRAME_STATS_SAMPLE_CAPACITY - 1)].timings[(size_t) metric];
+
+		if (timing != FRAME_STATS_NO_SAMPLE)
+		{
+			summary.max = std::max(summary.max, timing);
+		}
+	}
+
+	// Percentiles report the upper bound of their bucket, which may exceed the largest sample.
+	summary.p50 = std::min(summary.p50, summary.max);
+	summary.p95 = std::min(summary.p95, summary.max);
+	summary.p99 = std::min(summary.p99, summary.max);
+	summary.p999 = std::min(summary.p999, summary.max);
+
+	return summary;
+}
+
+uint64_t frame_stats_get_hitch_count(FrameStatsWindow window)
+{
+	return frame_stats_state.windows[(size_t) window].hitch_count;
+}
+
+uint64_t frame_stats_get_total_hitch_count()
+{
+	return frame_stats_state.total_hitch_count;
+}
+
+void frame_stats_set_hitch_threshold(uint64_t threshold_ns)
+{
+	frame_stats_state.hitch_threshold = threshold_ns;
+}
+
+void frame_stats_set_log_interval(uint64_t interval_ns)
+{
+	frame_stats_state.log_interval = interval_ns;
+}
+
+static void add_sample(FrameStatsWindowState& window, const FrameStatsSample& sample)
+{
+	for (size_t i = 0; i < METRIC_COUNT; i++)
+	{
+		if (sample.timings[i] != FRAME_STATS_NO_SAMPLE)
+		{
+			window.histograms[i].add(sample.timings[i]);
+		}
+	}
+
+	if (sample.is_hitch)
+	{
+		window.hitch_count++;
+	}
+}
+
+static void remove_sample(FrameStatsWindowState& window, const FrameStatsSample& sample)
+{
+	for (size_t i = 0; i < METRIC_COUNT; i++)
+	{
+		if (sample.timings[i] != FRAME_STATS_NO_SAMPLE)
+		{
+			window.histograms[i].remove(sample.timings[i]);
+		}
+	}
+
+	if (sample.is_hitch)
+	{
+		window.hitch_count--;
+	}
+}
+
+static void log_summary()
+{
+	auto frame = frame_stats_get_summary(FrameStatsWindow::SHORT, FrameStatsMetric::FRAME);
+	auto cpu = frame_stats_get_summary(FrameStatsWindow::SHORT, FrameStatsMetric::CPU);
+	auto gpu = frame_stats_get_summary(FrameStatsWindow::SHORT, FrameStatsMetric::GPU);
+
+	// In microseconds.
+	sl::log_debug(
+		"{} frames in the last second, {} hitches. Frame p50/p95/p99/p99.9/max: {}/{}/{}/{}/{} us, "
+		"CPU p50/p99/max: {}/{}/{} us, GPU p50/p99/max: {}/{}/{} us.",
+		frame.sample_count,
+		frame_stats_get_hitch_count(FrameStatsWindow::SHORT),
+		frame.p50 / 1000, frame.p95 / 1000, frame.p99 / 1000, frame.p999 / 1000, frame.max / 1000,
+		cpu.p50 / 1000, cpu.p99 / 1000, cpu.max / 1000,
+		gpu.p50 / 1000, gpu.p99 / 1000, gpu.max / 1000
+	);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The timings tracked for every frame.
+ */
+enum class FrameStatsMetric
+{
+	// The time between the starts of two consecutive frames.
+	FRAME,
+
+	// The time the main thread spent on a frame, excluding the time it was blocked waiting for the GPU.
+	CPU,
+
+	// The time the GPU spent executing the commands of a frame.
+	GPU,
+
+	MAX_ENUM
+};
+
+/**
+ * @brief The sliding windows statistics are kept over.
+ */
+enum class FrameStatsWindow
+{
+	// The last second.
+	SHORT,
+
+	// The last ten seconds.
+	LONG,
+
+	MAX_ENUM
+};
+
+// Marks a metric that was not measured for a frame, e.g. the GPU time before the first frame completed.
+#define FRAME_STATS_NO_SAMPLE UINT64_MAX
+
+/**
+ * @brief A histogram of durations in nanoseconds with logarithmically sized buckets.
+ *
+ * Every power of two is split into 2^SUB_BUCKET_BITS equally sized buckets, so every bucket is at most ~3% wide
+ * relative to the values it holds, no matter whether those are microseconds or seconds. Recording and removing samples
+ * is constant time, and percentiles are found by walking the buckets.
+ */
+struct FrameTimeHistogram
+{
+	static constexpr uint32_t SUB_BUCKET_BITS = 5;
+	static constexpr uint32_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+	// Values below SUB_BUCKET_COUNT get a bucket each, every power of two above that gets SUB_BUCKET_COUNT buckets.
+	static constexpr uint32_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+	std::array<uint32_t, BUCKET_COUNT> counts;
+	uint64_t sample_count;
+
+	void add(uint64_t ns);
+
+	/**
+	 * @brief Removes a sample that was previously added.
+	 */
+	void remove(uint64_t ns);
+
+	/**
+	 * @brief Returns the highest value that falls in the same bucket as the sample at a percentile.
+	 *
+	 * @param percentile In the range [0, 100].
+	 * @return 0 if the histogram is empty.
+	 */
+	uint64_t get_percentile(double percentile) const;
+
+	static uint32_t get_bucket_index(uint64_t ns);
+
+	static uint64_t get_bucket_upper_bound(uint32_t bucket_idx);
+};
+
+/**
+ * @brief The statistics of a metric over a window.
+ */
+struct FrameStatsSummary
+{
+	uint64_t sample_count;
+
+	uint64_t p50;
+	uint64_t p95;
+	uint64_t p99;
+	uint64_t p999;
+
+	// Exact, unlike the percentiles.
+	uint64_t max;
+};
+
+/**
+ * @brief Initializes the frame statistics.
+ *
+ * @return false if the sample storage could not be allocated.
+ */
+bool frame_stats_init();
+
+void frame_stats_shutdown();
+
+/**
+ * @brief Records the timings of a frame in nanoseconds, and logs a summary once every log interval.
+ *
+ * @param time_ns The time the frame ended, on the clock that measured the timings. Used to age samples out of windows.
+ * @param timings The timings of the frame, indexed by \ref FrameStatsMetric. Pass \ref FRAME_STATS_NO_SAMPLE for
+ * metrics that were not measured.
+ */
+void frame_stats_record(uint64_t time_ns, const std::array<uint64_t, (size_t) FrameStatsMetric::MAX_ENUM>& timings);
+
+FrameStatsSummary frame_stats_get_summary(FrameStatsWindow window, FrameStatsMetric metric);
+
+/**
+ * @brief Returns the amount of frames within a window whose frame time exceeded the hitch threshold.
+ */
+uint64_t frame_stats_get_hitch_count(FrameStatsWindow window);
+
+/**
+ * @brief Returns the amount of frames whose frame time exceeded the hitch threshold since initialization.
+ */
+uint64_t frame_stats_get_total_hitch_count();
+
+/**
+ * @brief Sets the frame time above which a frame counts as a hitch. Defaults to 50 ms.
+ *
+ * Only affects frames recorded afterwards.
+ */
+void frame_stats_set_hitch_threshold(uint64_t threshold_ns);
+
+/**
+ * @brief Sets how often \ref frame_stats_record logs a summary of the short window. 0 disables logging. Defaults to
+ * a second.
+ */
+void frame_stats_set_log_interval(uint64_t interval_ns);
@@ -1,30 +1,231 @@
 #include "handler/voxel_handler.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
-static std::vector<Voxel> voxels;
-static std::unordered_map<std::string, uint32_t> voxel_indices;
+#include <simple-logger.hpp>
 
-void voxel_handler_register_voxel(std::string id, Voxel voxel)
+static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+static struct
+{
+    bool frozen = false;
+
+    // Indexed by voxel index.
+    std::vector<Voxel> voxels;
+    std::vector<std::string> names;
+    std::vector<uint64_t> hashes;
+
+    // Perfect hash table, built when freezing. Every id hashes into a bucket, whose displacement selects a slot.
+    std::vector<uint32_t> displacements;
+    std::vector<uint64_t> slot_hashes;
+    std::vector<uint32_t> slot_indices;
+    uint64_t slot_mask = 0;
+
+    VoxelMaterialTable material_table;
+} registry;
+
+static uint64_t get_bucket(uint64_t hash)
+{
+    return (hash >> 32) % registry.displacements.size();
+}
+
+static uint64_t get_slot(uint64_t hash, uint32_t displacement)
+{
+    // Splitmix64 finalizer.
+    uint64_t x = hash ^ (displacement * 0x9E37'79B9'7F4A'7C15);
+
+    x = (x ^ (x >> 30)) * 0xBF58'476D'1CE4'E5B9;
+    x = (x ^ (x >> 27)) * 0x94D0'49BB'1331'11EB;
+    x = x ^ (x >> 31);
+
+    return x & registry.slot_mask;
+}
+
+bool voxel_handler_register_voxel(std::string_view id, Voxel voxel)
+{
+    if (registry.frozen)
+    {
+        sl::log_error("Failed to register voxel `{}`: the voxel registry is frozen.", id);
+        return false;
+    }
+
+    uint64_t hash = voxel_handler_hash_id(id);
+
+    for (uint32_t i = 0; i < registry.hashes.size(); i++)
+    {
+        if (registry.hashes[i] != hash) continue;
+
+        if (registry.names[i] != id)
+        {
+            sl::log_error("Failed to register voxel `{}`: its id hash collides with `{}`.", id, registry.names[i]);
+        }
+
+        return false;
+    }
+
+    registry.voxels.push_back(voxel);
+    registry.names.emplace_back(id);
+    registry.hashes.push_back(hash);
+
+    return true;
+}
+
+void voxel_handler_freeze()
 {
-    if (voxel_indices.contains(id))
+    if (registry.frozen) return;
+
+    registry.frozen = true;
+
+    registry.material_table = VoxelMaterialTable::create(registry.voxels);
+
+    uint64_t voxel_count = registry.voxels.size();
+
+    if (voxel_count == 0) return;
+
+    // Use roughly one key per bucket and a power of two slot count, so a slot is selected with a mask.
+    registry.displacements.assign(voxel_count, 0);
+
+    uint64_t slot_count = std::bit_ceil(voxel_count);
+    registry.slot_mask = slot_count - 1;
+    registry.slot_hashes.assign(slot_count, 0);
+    registry.slot_indices.assign(slot_count, EMPTY_SLOT);
+
+    std::vector<std::vector<uint32_t>> buckets(voxel_count);
+
+    for (uint32_t i = 0; i < voxel_count; i++)
+    {
+        buckets[get_bucket(registry.hashes[i])].push_back(i);
+    }
+
+    std::vector<uint32_t> bucket_order(voxel_count);
+
+    for (uint32_t i = 0; i < voxel_count; i++)
+    {
+        bucket_order[i] = i;
+    }
+
+    // Place the largest buckets first, while most slots are still free.
+    std::sort(bucket_order.begin(), bucket_order.end(), [&buckets](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<uint64_t> bucket_slots;
+
+    for (uint32_t bucket_idx : bucket_order)
     {
-        return;
+        auto& bucket = buckets[bucket_idx];
+
+        if (bucket.empty()) break;
+
+        // Find a displacement that maps every key of the bucket to a distinct free slot.
+        for (uint32_t displacement = 0;; displacement++)
+        {
+            bucket_slots.clear();
+
+            bool fits = true;
+
+            for (uint32_t voxel_idx : bucket)
+            {
+                uint64_t slot = get_slot(registry.hashes[voxel_idx], displacement);
+
+                if (registry.slot_indices[slot] != EMPTY_SLOT ||
+                    std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end())
+                {
+                    fits = false;
+                    break;
+                }
+
+                bucket_slots.push_back(slot);
+            }
+
+            if (!fits) continue;
+
+            for (uint32_t i = 0; i < bucket.size(); i++)
+            {
+                registry.slot_hashes[bucket_slots[i]] = registry.hashes[bucket[i]];
+                registry.slot_indices[bucket_slots[i]] = bucket[i];
+            }
+
+            registry.displacements[bucket_idx] = displacement;
+            break;
+        }
     }
 
-    uint32_t idx = voxels.size();
-    voxels.push_back(voxel);
+    sl::log_info("Froze the voxel registry with {} voxels.", voxel_count);
+}
+
+bool voxel_handler_is_frozen()
+{
+    return registry.frozen;
+}
+
+std::optional<uint32_t> voxel_handler_get_voxel_index(std::string_view id)
+{
+    auto voxel_idx = voxel_handler_get_voxel_index(VoxelId { voxel_handler_hash_id(id) });
 
-    voxel_indices[id] = idx;
+    if (!voxel_idx.has_value() || registry.names[*voxel_idx] != id)
+    {
+        return std::nullopt;
+    }
+
+    return voxel_idx;
 }
 
-std::optional<uint32_t> voxel_handler_get_voxel_index(std::string id)
+std::optional<uint32_t> voxel_handler_get_voxel_index(VoxelId id)
 {
-    if (!voxel_indices.contains(id))
+    if (!registry.frozen)
+    {
+        // Registration is still ongoing, fall back to a scan.
+        for (uint32_t i = 0; i < registry.hashes.size(); i++)
+        {
+            if (registry.hashes[i] == id.hash)
+            {
+                return i;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    if (registry.displacements.empty())
     {
         return std::nullopt;
     }
 
-    return voxel_indices[id];
+    uint64_t slot = get_slot(id.hash, registry.displacements[get_bucket(id.hash)]);
+
+    if (registry.slot_hashes[slot] != id.hash || registry.slot_indices[slot] == EMPTY_SLOT)
+    {
+        return std::nullopt;
+    }
+
+    return registry.slot_indices[slot];
+}
+
+std::string_view voxel_handler_get_voxel_name(uint32_t voxel_index)
+{
+    return registry.names[voxel_index];
+}
+
+std::span<const Voxel> voxel_handler_get_voxels()
+{
+    return registry.voxels;
+}
+
+void voxel_handler_update_voxel(uint32_t voxel_index, Voxel voxel)
+{
+    registry.voxels[voxel_index] = voxel;
+
+    if (registry.frozen)
+    {
+        registry.material_table.set_material(voxel_index, voxel);
+    }
+}
+
+VoxelMaterialTable* voxel_handler_get_material_table()
+{
+    return registry.frozen ? &registry.material_table : nullptr;
 }
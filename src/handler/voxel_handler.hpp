@@ -1,10 +1,89 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
-#include <string>
+#include <span>
+#include <string_view>
 
 #include "voxel/voxel.hpp"
+#include "voxel/voxel_material_table.hpp"
 
-void voxel_handler_register_voxel(std::string id, Voxel voxel);
+/**
+ * @brief A pre-hashed voxel string id.
+ *
+ * Create one with \ref voxel_id to resolve the hash at compile time.
+ */
+struct VoxelId
+{
+    uint64_t hash;
+};
 
-std::optional<uint32_t> voxel_handler_get_voxel_index(std::string id);
+/**
+ * @brief Hashes a voxel string id using 64-bit FNV-1a.
+ */
+constexpr uint64_t voxel_handler_hash_id(std::string_view id)
+{
+    uint64_t hash = 0xCBF2'9CE4'8422'2325;
+
+    for (char c : id)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x0000'0100'0000'01B3;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Hashes a voxel string id at compile time.
+ */
+consteval VoxelId voxel_id(std::string_view id)
+{
+    return VoxelId { voxel_handler_hash_id(id) };
+}
+
+/**
+ * @brief Registers a voxel type. The index of the voxel is the amount of voxels registered before it.
+ *
+ * @return false if the registry is frozen or if the id (or its hash) is already in use.
+ */
+bool voxel_handler_register_voxel(std::string_view id, Voxel voxel);
+
+/**
+ * @brief Freezes the registry, after which no voxels can be registered anymore.
+ *
+ * Builds a perfect hash table over all registered ids, so that every lookup afterwards takes a single probe, and
+ * builds the material table that gets uploaded to the GPU.
+ */
+void voxel_handler_freeze();
+
+bool voxel_handler_is_frozen();
+
+std::optional<uint32_t> voxel_handler_get_voxel_index(std::string_view id);
+
+/**
+ * @brief Looks up a voxel index by a pre-hashed id. Does not compare the string id, which makes it the fastest lookup.
+ */
+std::optional<uint32_t> voxel_handler_get_voxel_index(VoxelId id);
+
+/**
+ * @brief Returns the interned string id of a registered voxel.
+ */
+std::string_view voxel_handler_get_voxel_name(uint32_t voxel_index);
+
+/**
+ * @brief Returns all registered voxels, indexed by voxel index.
+ */
+std::span<const Voxel> voxel_handler_get_voxels();
+
+/**
+ * @brief Changes the properties of a registered voxel. The change is propagated to the material table.
+ */
+void voxel_handler_update_voxel(uint32_t voxel_index, Voxel voxel);
+
+/**
+ * @brief Returns the material table of the registry.
+ *
+ * @return nullptr if the registry is not frozen yet.
+ */
+VoxelMaterialTable* voxel_handler_get_material_table();
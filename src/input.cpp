@@ -1,6 +1,9 @@
 #include "input.hpp"
 
+#include <vector>
+
 #include "event.hpp"
+#include "input_recording.hpp"
 
 struct MouseState
 {
@@ -19,14 +22,30 @@ static MouseState mouse_previous;
 static KeyboardState keyboard_current;
 static KeyboardState keyboard_previous;
 
+// Raw motion since the last update.
+static std::vector<MouseMotionSample> mouse_motion_samples;
+static vector2f mouse_delta;
+
 void input_update()
 {
 	mouse_previous = mouse_current;
 	keyboard_previous = keyboard_current;
+
+	// Keeps its capacity, so high rate mice don't allocate every frame.
+	mouse_motion_samples.clear();
+	mouse_delta = vector2f { 0.0f, 0.0f };
 }
 
 void input_process_keys(Keys key, bool down)
 {
+	// Recorded, or dropped when a replay overrides live input.
+	InputRecord record = { InputRecordType::KEY, 0, { .i32 = { static_cast<int32_t>(key), down } } };
+
+	if (!input_recording_capture(record))
+	{
+		return;
+	}
+
 	// Fire event if the state has changed
 	if (keyboard_current.keys_pressed[static_cast<int>(key)] != down)
 	{
@@ -40,6 +59,13 @@ void input_process_keys(Keys key, bool down)
 
 void input_process_button(MouseButtons button, bool down)
 {
+	InputRecord record = { InputRecordType::BUTTON, 0, { .i32 = { static_cast<int32_t>(button), down } } };
+
+	if (!input_recording_capture(record))
+	{
+		return;
+	}
+
 	// Fire event if the state has changed
 	if (mouse_current.buttons[static_cast<int>(button)] != down)
 	{
@@ -54,6 +80,13 @@ void input_process_button(MouseButtons button, bool down)
 
 void input_process_mouse_move(vector2i pos)
 {
+	InputRecord record = { InputRecordType::MOUSE_MOVE, 0, { .i32 = { pos.x, pos.y } } };
+
+	if (!input_recording_capture(record))
+	{
+		return;
+	}
+
 	if (mouse_current.pos != pos)
 	{
 		mouse_current.pos = pos;
@@ -68,6 +101,13 @@ void input_process_mouse_move(vector2i pos)
 
 void input_process_mouse_wheel(int8_t dz)
 {
+	InputRecord record = { InputRecordType::MOUSE_WHEEL, 0, { .i32 = { dz, 0 } } };
+
+	if (!input_recording_capture(record))
+	{
+		return;
+	}
+
 	// No internal state to handle.
 
 	// Fire event
@@ -76,6 +116,21 @@ void input_process_mouse_wheel(int8_t dz)
 	event_fire(EventCodes::ON_MOUSE_WHEEL_MOVE, ctx);
 }
 
+void input_process_raw_mouse_motion(uint64_t time, vector2f delta)
+{
+	InputRecord record = { InputRecordType::RAW_MOUSE_MOTION, 0, { .f32 = { delta.x, delta.y } } };
+
+	if (!input_recording_capture(record))
+	{
+		return;
+	}
+
+	// No event, as samples may arrive thousands of times per second. They are read by polling instead.
+	mouse_motion_samples.push_back(MouseMotionSample { time, delta });
+
+	mouse_delta += delta;
+}
+
 // Exported getters
 
 bool input_is_key_down(Keys key)
@@ -127,3 +182,13 @@ vector2i input_get_previous_mouse_position()
 {
 	return mouse_previous.pos;
 }
+
+vector2f input_get_mouse_delta()
+{
+	return mouse_delta;
+}
+
+std::span<const MouseMotionSample> input_get_mouse_motion_samples()
+{
+	return mouse_motion_samples;
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 #include "math/vector2.hpp"
 
@@ -149,7 +150,20 @@ enum class Keys {
 };
 
 /**
- * @brief Gets called by the engine every frame to update the input backend.
+ * @brief Relative mouse motion as reported by the device, before pointer acceleration.
+ */
+struct MouseMotionSample
+{
+	// When the platform received the sample, on \ref platform_get_time_ns.
+	uint64_t time;
+
+	// In device units, often called counts or mickeys.
+	vector2f delta;
+};
+
+/**
+ * @brief Gets called by the engine every frame to update the input backend, or after every simulation tick while
+ * input is recorded or replayed.
  */
 void input_update();
 
@@ -253,6 +267,21 @@ vector2i input_get_mouse_position();
  */
 vector2i input_get_previous_mouse_position();
 
+/**
+ * @brief Returns the raw mouse motion accumulated since the last \ref input_update.
+ *
+ * Only reported while the window has focus. Reading it right before recording a frame gives the lowest latency.
+ */
+vector2f input_get_mouse_delta();
+
+/**
+ * @brief Returns the raw mouse motion samples received since the last \ref input_update, oldest first.
+ *
+ * Lets motion be integrated at the rate the mouse reports it, e.g. to split it between simulation ticks.
+ */
+std::span<const MouseMotionSample> input_get_mouse_motion_samples();
+
 void input_process_button(MouseButtons button, bool down);
 void input_process_mouse_move(vector2i pos);
 void input_process_mouse_wheel(int8_t dz);
+void input_process_raw_mouse_motion(uint64_t time, vector2f delta);
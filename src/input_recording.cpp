@@ -0,0 +1,443 @@
+#include "input_recording.hpp"
+
+#include <bit>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+#include <simple-logger.hpp>
+
+#include "event.hpp"
+#include "input.hpp"
+#include "platform/platform.hpp"
+
+// "IREC", little endian.
+#define INPUT_RECORDING_MAGIC 0x43455249u
+#define INPUT_RECORDING_VERSION 1u
+
+// Recorded input is written out whenever this much accumulated.
+#define INPUT_RECORDING_FLUSH_SIZE (64 * 1024)
+
+enum class InputRecordingMode
+{
+	NONE,
+	RECORD,
+	REPLAY
+};
+
+/*
+ * A recording is a header of the magic, version and tick rate as little endian 32-bit integers, followed by records.
+ *
+ * Every record is its type as a byte, the ticks since the previous record as an unsigned LEB128 varint, and a payload:
+ * KEY and BUTTON: a varint of the key or button shifted left once, with whether it is down in the low bit.
+ * MOUSE_MOVE: two zigzag varints. MOUSE_WHEEL: a zigzag varint. RAW_MOUSE_MOTION: two little endian floats. END: none.
+ */
+static struct
+{
+	InputRecordingMode mode;
+
+	// Recording.
+	std::ofstream file;
+	std::vector<uint8_t> buffer;
+	uint64_t tick;
+	uint64_t last_tick;
+
+	// Replay.
+	std::vector<uint8_t> data;
+	size_t read_offset;
+	std::optional<InputRecord> next_record;
+	bool feeding;
+	bool ended;
+} recording_state;
+
+static void write_varint(uint64_t value);
+static void write_u32(uint32_t value);
+static void write_record(const InputRecord& record);
+static bool flush_recording();
+
+static bool read_varint(uint64_t& value);
+static bool read_u32(uint32_t& value);
+static std::optional<InputRecord> read_record();
+static void replay_record(const InputRecord& record);
+
+// Maps signed values to unsigned ones with small magnitudes staying small, so they make short varints.
+static uint64_t zigzag_encode(int32_t value);
+static int32_t zigzag_decode(uint64_t value);
+
+bool input_recording_start(const std::string& path, uint32_t tick_rate)
+{
+	if (recording_state.mode != InputRecordingMode::NONE)
+	{
+		sl::log_error("Can't record input while already recording or replaying.");
+		return false;
+	}
+
+	recording_state.file.open(path, std::ios::binary | std::ios::trunc);
+
+	if (!recording_state.file)
+	{
+		sl::log_error("Failed to open `{}` to record input.", path);
+		return false;
+	}
+
+	recording_state.mode = InputRecordingMode::RECORD;
+	recording_state.tick = 0;
+	recording_state.last_tick = 0;
+
+	write_u32(INPUT_RECORDING_MAGIC);
+	write_u32(INPUT_RECORDING_VERSION);
+	write_u32(tick_rate);
+
+	sl::log_info("Recording input to `{}`.", path);
+
+	return true;
+}
+
+bool input_replay_start(const std::string& path, uint32_t tick_rate)
+{
+	if (recording_state.mode != InputRecordingMode::NONE)
+	{
+		sl::log_error("Can't replay input while already recording or replaying.");
+		return false;
+	}
+
+	std::ifstream file(path, std::ios::binary | std::ios::in | std::ios::ate);
+
+	if (!file)
+	{
+		sl::log_error("Failed to open the input recording `{}`.", path);
+		return false;
+	}
+
+	recording_state.data.resize(static_cast<size_t>(file.tellg()));
+
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(recording_state.data.data()), recording_state.data.size());
+
+	recording_state.read_offset = 0;
+
+	uint32_t magic, version, recorded_tick_rate;
+
+	if (!read_u32(magic) || !read_u32(version) || !read_u32(recorded_tick_rate) || magic != INPUT_RECORDING_MAGIC)
+	{
+		sl::log_error("`{}` is not an input recording.", path);
+		return false;
+	}
+
+	if (version != INPUT_RECORDING_VERSION)
+	{
+		sl::log_error("The input recording `{}` has the unsupported version {}.", path, version);
+		return false;
+	}
+
+	if (recorded_tick_rate != tick_rate)
+	{
+		sl::log_error("The input recording `{}` was made at {} ticks per second, but the simulation runs at {}.",
+			path, recorded_tick_rate, tick_rate);
+		return false;
+	}
+
+	recording_state.mode = InputRecordingMode::REPLAY;
+	recording_state.last_tick = 0;
+	recording_state.next_record = read_record();
+	recording_state.ended = false;
+
+	sl::log_info("Replaying input from `{}`.", path);
+
+	return true;
+}
+
+void input_recording_shutdown()
+{
+	if (recording_state.mode == InputRecordingMode::RECORD)
+	{
+		write_record(InputRecord { InputRecordType::END, recording_state.tick, {} });
+
+		flush_recording();
+
+		recording_state.file.close();
+		recording_state.buffer = {};
+	}
+	else if (recording_state.mode == InputRecordingMode::REPLAY)
+	{
+		recording_state.data = {};
+		recording_state.next_record.reset();
+	}
+
+	recording_state.mode = InputRecordingMode::NONE;
+}
+
+bool input_recording_is_active()
+{
+	return recording_state.mode == InputRecordingMode::RECORD;
+}
+
+bool input_replay_is_active()
+{
+	return recording_state.mode == InputRecordingMode::REPLAY;
+}
+
+void input_recording_set_tick(uint64_t tick)
+{
+	recording_state.tick = tick;
+}
+
+bool input_replay_feed(uint64_t tick)
+{
+	if (recording_state.mode != InputRecordingMode::REPLAY || recording_state.ended)
+	{
+		return false;
+	}
+
+	std::optional<InputRecord>& next = recording_state.next_record;
+
+	while (next && next->tick <= tick && next->type != InputRecordType::END)
+	{
+		replay_record(*next);
+
+		next = read_record();
+	}
+
+	// Recordings cut short, e.g. by a crash, end right after their last complete record.
+	if (next && (next->type != InputRecordType::END || next->tick > tick))
+	{
+		return true;
+	}
+
+	if (!next)
+	{
+		sl::log_warn("The input recording ended without an end marker.");
+	}
+
+	sl::log_info("Reached the end of the input recording at tick {}.", tick);
+
+	recording_state.ended = true;
+
+	event_fire(EventCodes::ON_WINDOW_CLOSE, EventContext {});
+
+	return false;
+}
+
+bool input_recording_capture(InputRecord record)
+{
+	switch (recording_state.mode)
+	{
+		case InputRecordingMode::RECORD:
+			record.tick = recording_state.tick;
+			write_record(record);
+
+			return true;
+		case InputRecordingMode::REPLAY:
+			// Only input fed from the recording gets through.
+			return recording_state.feeding;
+		default:
+			return true;
+	}
+}
+
+static uint64_t zigzag_encode(int32_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 31);
+}
+
+static int32_t zigzag_decode(uint64_t value)
+{
+	return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static void write_varint(uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		recording_state.buffer.push_back(static_cast<uint8_t>(value) | 0x80);
+		value >>= 7;
+	}
+
+	recording_state.buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static void write_u32(uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		recording_state.buffer.push_back(static_cast<uint8_t>(value >> (i * 8)));
+	}
+}
+
+static void write_record(const InputRecord& record)
+{
+	recording_state.buffer.push_back(static_cast<uint8_t>(record.type));
+
+	write_varint(record.tick - recording_state.last_tick);
+	recording_state.last_tick = record.tick;
+
+	switch (record.type)
+	{
+		case InputRecordType::KEY:
+		case InputRecordType::BUTTON:
+			write_varint((static_cast<uint64_t>(record.data.i32[0]) << 1) | (record.data.i32[1] ? 1 : 0));
+			break;
+		case InputRecordType::MOUSE_MOVE:
+			write_varint(zigzag_encode(record.data.i32[0]));
+			write_varint(zigzag_encode(record.data.i32[1]));
+			break;
+		case InputRecordType::MOUSE_WHEEL:
+			write_varint(zigzag_encode(record.data.i32[0]));
+			break;
+		case InputRecordType::RAW_MOUSE_MOTION:
+			write_u32(std::bit_cast<uint32_t>(record.data.f32[0]));
+			write_u32(std::bit_cast<uint32_t>(record.data.f32[1]));
+			break;
+		default:
+			break;
+	}
+
+	if (recording_state.buffer.size() >= INPUT_RECORDING_FLUSH_SIZE)
+	{
+		flush_recording();
+	}
+}
+
+static bool flush_recording()
+{
+	recording_state.file.write(
+		reinterpret_cast<const char*>(recording_state.buffer.data()),
+		recording_state.buffer.size());
+	recording_state.buffer.clear();
+
+	if (!recording_state.file)
+	{
+		sl::log_error("Failed to write the input recording.");
+		return false;
+	}
+
+	return true;
+}
+
+static bool read_varint(uint64_t& value)
+{
+	value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (recording_state.read_offset >= recording_state.data.size())
+		{
+			return false;
+		}
+
+		uint8_t byte = recording_state.data[recording_state.read_offset++];
+
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool read_u32(uint32_t& value)
+{
+	if (recording_state.data.size() - recording_state.read_offset < 4)
+	{
+		return false;
+	}
+
+	value = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		value |= static_cast<uint32_t>(recording_state.data[recording_state.read_offset++]) << (i * 8);
+	}
+
+	return true;
+}
+
+static std::optional<InputRecord> read_record()
+{
+	if (recording_state.read_offset >= recording_state.data.size())
+	{
+		return std::nullopt;
+	}
+
+	InputRecord out = {};
+	out.type = static_cast<InputRecordType>(recording_state.data[recording_state.read_offset++]);
+
+	uint64_t tick_delta, a, b;
+	uint32_t x, y;
+
+	if (out.type >= InputRecordType::MAX_ENUM || !read_varint(tick_delta))
+	{
+		return std::nullopt;
+	}
+
+	recording_state.last_tick += tick_delta;
+	out.tick = recording_state.last_tick;
+
+	switch (out.type)
+	{
+		case InputRecordType::KEY:
+		case InputRecordType::BUTTON:
+			if (!read_varint(a)) return std::nullopt;
+
+			// Keys and buttons index the input state, so they must be in range.
+			if ((a >> 1) >= (out.type == InputRecordType::KEY ? static_cast<uint64_t>(Keys::MAX_KEYS) :
+				static_cast<uint64_t>(MouseButtons::MAX_BUTTONS))) return std::nullopt;
+
+			out.data.i32[0] = static_cast<int32_t>(a >> 1);
+			out.data.i32[1] = static_cast<int32_t>(a & 1);
+			break;
+		case InputRecordType::MOUSE_MOVE:
+			if (!read_varint(a) || !read_varint(b)) return std::nullopt;
+
+			out.data.i32[0] = zigzag_decode(a);
+			out.data.i32[1] = zigzag_decode(b);
+			break;
+		case InputRecordType::MOUSE_WHEEL:
+			if (!read_varint(a)) return std::nullopt;
+
+			out.data.i32[0] = zigzag_decode(a);
+			break;
+		case InputRecordType::RAW_MOUSE_MOTION:
+			if (!read_u32(x) || !read_u32(y)) return std::nullopt;
+
+			out.data.f32[0] = std::bit_cast<float>(x);
+			out.data.f32[1] = std::bit_cast<float>(y);
+			break;
+		default:
+			break;
+	}
+
+	return out;
+}
+
+static void replay_record(const InputRecord& record)
+{
+	recording_state.feeding = true;
+
+	switch (record.type)
+	{
+		case InputRecordType::KEY:
+			input_process_keys(static_cast<Keys>(record.data.i32[0]), record.data.i32[1] != 0);
+			break;
+		case InputRecordType::BUTTON:
+			input_process_button(static_cast<MouseButtons>(record.data.i32[0]), record.data.i32[1] != 0);
+			break;
+		case InputRecordType::MOUSE_MOVE:
+			input_process_mouse_move(vector2i { record.data.i32[0], record.data.i32[1] });
+			break;
+		case InputRecordType::MOUSE_WHEEL:
+			input_process_mouse_wheel(static_cast<int8_t>(record.data.i32[0]));
+			break;
+		case InputRecordType::RAW_MOUSE_MOTION:
+			// The samples are stamped with the time they are replayed at.
+			input_process_raw_mouse_motion(platform_get_time_ns(), vector2f { record.data.f32[0], record.data.f32[1] });
+			break;
+		default:
+			break;
+	}
+
+	recording_state.feeding = false;
+}
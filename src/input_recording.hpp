@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief The kinds of input a recording holds, one per input_process_* function.
+ */
+enum class InputRecordType : uint8_t
+{
+	KEY,
+	BUTTON,
+	MOUSE_MOVE,
+	MOUSE_WHEEL,
+	RAW_MOUSE_MOTION,
+
+	// Marks the tick the recording stopped at. Replays close the window when reaching it.
+	END,
+
+	MAX_ENUM
+};
+
+/**
+ * @brief A single input, stamped with the tick it was received before.
+ */
+struct InputRecord
+{
+	InputRecordType type;
+
+	// The amount of ticks run before the input was received. It is replayed right before the tick with this index.
+	uint64_t tick;
+
+	// KEY and BUTTON: `i32[0]` is the key or button, `i32[1]` whether it is down. <br>
+	// MOUSE_MOVE: `i32` is the position. <br>
+	// MOUSE_WHEEL: `i32[0]` is the direction. <br>
+	// RAW_MOUSE_MOTION: `f32` is the delta.
+	union
+	{
+		int32_t i32[2];
+		float f32[2];
+	} data;
+};
+
+/**
+ * @brief Starts writing all input to a file, to replay it later with \ref input_replay_start.
+ *
+ * @param tick_rate The simulation tick rate. Replays are refused at any other rate.
+ */
+bool input_recording_start(const std::string& path, uint32_t tick_rate);
+
+/**
+ * @brief Starts feeding the input of a recording through the input subsystem, ignoring all live input.
+ *
+ * Input only reaches the input subsystem when \ref input_replay_feed is called for its tick, so a replay sees the
+ * same input before every tick as the recorded run did.
+ */
+bool input_replay_start(const std::string& path, uint32_t tick_rate);
+
+/**
+ * @brief Finishes a recording or replay. Recordings are marked as ending at the current tick.
+ */
+void input_recording_shutdown();
+
+bool input_recording_is_active();
+bool input_replay_is_active();
+
+/**
+ * @brief Sets the tick stamped onto input recorded from now on, i.e. the amount of ticks run so far.
+ */
+void input_recording_set_tick(uint64_t tick);
+
+/**
+ * @brief Feeds the recorded input of all ticks up to and including `tick` through the input subsystem.
+ *
+ * Fires \ref ON_WINDOW_CLOSE once the end of the recording is reached.
+ *
+ * @return false once the end of the recording was reached.
+ */
+bool input_replay_feed(uint64_t tick);
+
+/**
+ * @brief Gets called by the input subsystem for every input it processes.
+ *
+ * Used only internally.
+ *
+ * @return false if the input must be dropped, because it is live input during a replay.
+ */
+bool input_recording_capture(InputRecord record);
@@ -1,31 +1,133 @@
+#include "container/triple_buffer.hpp"
 #include "handler/voxel_handler.hpp"
 #include "platform/platform.hpp"
 #include "renderer/renderer.hpp"
+#include "voxel/chunk_streamer.hpp"
+#include "voxel/region_storage.hpp"
 #include "voxel/voxel_grid.hpp"
 #include "clock.hpp"
 #include "event.hpp"
+#include "frame_stats.hpp"
 #include "input.hpp"
+#include "input_recording.hpp"
+#include "profiler.hpp"
+#include "tick_scheduler.hpp"
+
+#include <cstring>
 
 #include <simple-logger.hpp>
 
+// Simulation ticks per second.
+static constexpr uint32_t SIMULATION_TICK_RATE = 60;
+
+// The most ticks a frame runs to catch up after a stall.
+static constexpr uint32_t SIMULATION_MAX_TICKS_PER_UPDATE = 8;
+
+// The default frame rate cap. Without one, non-vsync present modes render as fast as possible.
+static constexpr uint32_t DEFAULT_FRAME_RATE_LIMIT = 240;
+
+/**
+ * @brief The state advanced by simulation ticks.
+ */
+struct SimulationState
+{
+    vector3f camera_position;
+    vector3f camera_direction;
+};
+
+/**
+ * @brief The state of a tick as handed to rendering by the simulation thread.
+ */
+struct SimulationSnapshot
+{
+    // The state of the tick before, to interpolate from.
+    SimulationState previous;
+    SimulationState current;
+
+    // When the tick finished, on Clock::now.
+    uint64_t time;
+};
+
 void on_window_close(uint16_t event_code, EventContext ctx);
 
+void simulate_tick(uint64_t tick);
+SimulationState get_render_state();
+
+std::optional<VoxelOctree> load_test_chunk(vector3i chunk_position, uint8_t depth);
+void save_test_chunk(vector3i chunk_position, const VoxelOctree& octree);
+std::optional<VoxelOctree> generate_test_chunk(vector3i chunk_position, uint8_t depth);
+
 static struct
 {
     bool is_running = true;
 
+    // Headless clients run the world without a window or renderer, e.g. on servers and benchmark runners.
+    PlatformBackend platform_backend = PlatformBackend::WINDOWED;
+
     Clock delta_clock;
     double delta_time;
 
+    // An input recording to write, or to replay instead of live input.
+    const char* record_input_path = nullptr;
+    const char* replay_input_path = nullptr;
+
+    // Frames per second, or 0 to render as fast as possible.
+    uint32_t frame_rate_limit = DEFAULT_FRAME_RATE_LIMIT;
+
+    // When the next frame may start, on platform_get_time_ns.
+    uint64_t next_frame_time;
+
+    // How long the previous frame waited in the frame limiter, which doesn't count towards its CPU time.
+    uint64_t frame_limiter_wait_time = 0;
+
+    // Declared before the streamer, whose workers load chunks from it until they are stopped.
+    std::unique_ptr<RegionStorage> test_grid_storage;
+
     VoxelGrid test_grid;
+    std::unique_ptr<ChunkStreamer> test_grid_streamer;
+
+    // Whether the simulation ticks on its own thread rather than between frames.
+    bool simulate_on_thread = false;
+
+    TickScheduler tick_scheduler;
+
+    // Only accessed by the thread that ticks.
+    SimulationState simulation;
+    SimulationState previous_simulation;
+
+    std::unique_ptr<TickThread> simulation_thread;
+    TripleBuffer<SimulationSnapshot> simulation_snapshots;
 } client_state;
 
 bool client_initialize();
 bool client_run();
 void client_shutdown();
 
-int main()
+int main(int argc, char** argv)
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--headless") == 0)
+        {
+            client_state.platform_backend = PlatformBackend::HEADLESS;
+
+            // Without frames to render, only run the loop as often as the simulation ticks.
+            client_state.frame_rate_limit = SIMULATION_TICK_RATE;
+        }
+        else if (std::strcmp(argv[i], "--simulation-thread") == 0)
+        {
+            client_state.simulate_on_thread = true;
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            client_state.record_input_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            client_state.replay_input_path = argv[++i];
+        }
+    }
+
     if (!client_initialize())
     {
         sl::log_fatal("Failed to initialize the client.");
@@ -48,19 +150,50 @@ bool client_initialize()
     sl::log_info("Initializing...");
 
     // Initialize.
+    clock_init();
+    profiler_init();
+
+    if (!frame_stats_init())
+    {
+        sl::log_fatal("Failed to initialize the frame statistics.");
+        return false;
+    }
+
     if (!event_init())
     {
         sl::log_fatal("Failed to initialize the event subsystem.");
         return false;
     }
 
-    if (!platform_init("Industria", 100, 100, 400, 400))
+    if (client_state.record_input_path && !input_recording_start(client_state.record_input_path, SIMULATION_TICK_RATE))
+    {
+        sl::log_fatal("Failed to start recording input.");
+        return false;
+    }
+
+    if (client_state.replay_input_path && !input_replay_start(client_state.replay_input_path, SIMULATION_TICK_RATE))
+    {
+        sl::log_fatal("Failed to start replaying input.");
+        return false;
+    }
+
+    // Recordings are stamped with the ticks of the main loop, so they need the simulation to tick there.
+    if (client_state.simulate_on_thread && (input_recording_is_active() || input_replay_is_active()))
+    {
+        sl::log_warn("Ticking the simulation on the main thread, as input is recorded or replayed.");
+
+        client_state.simulate_on_thread = false;
+    }
+
+    if (!platform_init(client_state.platform_backend, "Industria", 100, 100, 400, 400))
     {
         sl::log_fatal("Failed to initialize the platform subsystem.");
         return false;
     }
 
-    if (!renderer_initialize())
+    bool is_headless = client_state.platform_backend == PlatformBackend::HEADLESS;
+
+    if (!is_headless && !renderer_initialize())
     {
         sl::log_fatal("Failed to initialize the renderer subsystem.");
         return false;
@@ -68,15 +201,63 @@ bool client_initialize()
 
     event_add_listener(EventCodes::ON_WINDOW_CLOSE, on_window_close);
 
+    // Only the latest mouse position and window size matter, no matter how many the platform reports per frame.
+    event_set_dispatch_mode(EventCodes::ON_MOUSE_MOVE, EventDispatchMode::EVENT_DISPATCH_COALESCED);
+    event_set_dispatch_mode(EventCodes::ON_WINDOW_RESIZE, EventDispatchMode::EVENT_DISPATCH_COALESCED);
+
     voxel_handler_register_voxel("sand", Voxel { vector4f { 1.0f, 0.98f, 0.725f, 1.0f } } );
     voxel_handler_register_voxel("grass", Voxel { vector4f { 0.459f, 0.741f, 0.392f, 1.0f } } );
 
+    voxel_handler_freeze();
+
+    if (!is_headless && !renderer_set_voxel_material_table(voxel_handler_get_material_table()))
+    {
+        sl::log_fatal("Failed to upload the voxel materials.");
+        return false;
+    }
+
+    client_state.test_grid_storage = RegionStorage::create("saves/world");
+
+    if (!client_state.test_grid_storage)
+    {
+        sl::log_fatal("Failed to open the world save.");
+        return false;
+    }
+
     client_state.test_grid = std::move(VoxelGrid::create(4, 0.1f).value());
 
-    client_state.test_grid.set_voxel({0, 0, 0}, *voxel_handler_get_voxel_index("sand"));
-    client_state.test_grid.set_voxel({1, 0, 0}, *voxel_handler_get_voxel_index("grass"));
+    client_state.simulation.camera_position = vector3f { 0.0f, 0.0f, 0.0f };
+    client_state.simulation.camera_direction = vector3f { 0.0f, 0.0f, 1.0f };
+    client_state.previous_simulation = client_state.simulation;
+
+    client_state.tick_scheduler = TickScheduler::create(SIMULATION_TICK_RATE, SIMULATION_MAX_TICKS_PER_UPDATE);
+
+    if (client_state.simulate_on_thread)
+    {
+        // Publish the initial state, so rendering has a snapshot before the first tick.
+        client_state.simulation_snapshots.get_write_buffer() = SimulationSnapshot {
+            client_state.previous_simulation,
+            client_state.simulation,
+            Clock::now()
+        };
+        client_state.simulation_snapshots.publish();
+
+        client_state.simulation_thread = TickThread::create(client_state.tick_scheduler, simulate_tick);
+    }
+
+    // Chunks around the camera are generated in the background.
+    client_state.test_grid_streamer = ChunkStreamer::create(
+        &client_state.test_grid,
+        load_test_chunk,
+        std::max(std::thread::hardware_concurrency(), 2u) - 1,
+        8,
+        64 * 1024 * 1024
+    );
+
+    client_state.test_grid_streamer->evictor = save_test_chunk;
 
     client_state.delta_clock.reset();
+    client_state.next_frame_time = platform_get_time_ns();
 
     return true;
 }
@@ -87,54 +268,158 @@ bool client_run()
 
     bool error_happened = false;
 
-    static int frames = 0;
-    static float acc = 0;
+    // Recorded and replayed runs advance input after every tick instead of every frame, so each tick sees the same
+    // input edges and motion samples no matter how the ticks fell into frames.
+    bool is_input_per_tick = input_recording_is_active() || input_replay_is_active();
 
     while (client_state.is_running)
     {
+        PROFILE_FRAME();
+
         // Calculate delta time.
-		client_state.delta_time = client_state.delta_clock.get_elapsed_time();
-		client_state.delta_clock.reset();
+        uint64_t frame_time = client_state.delta_clock.restart();
+
+		client_state.delta_time = frame_time * 1e-9;
+
+        // Record the timings of the previous frame. Its CPU time excludes the time spent waiting on the GPU and in the
+        // frame limiter.
+        uint64_t wait_time = renderer_get_last_wait_time() + client_state.frame_limiter_wait_time;
 
-        acc += client_state.delta_time;
-        frames++;
+        frame_stats_record(client_state.delta_clock.start_time, {
+            frame_time,
+            frame_time - std::min(wait_time, frame_time),
+            renderer_get_last_gpu_frame_time().value_or(FRAME_STATS_NO_SAMPLE)
+        });
 
-        if (acc >= 1.0f)
+        // Poll platform messages.
         {
-            sl::log_debug("It has been {} seconds with an average frame time of {} seconds and frame rate of {} fps.", acc, acc / frames, frames/acc);
+            PROFILE_SCOPE("poll messages");
+
+            if (!platform_poll_messages())
+            {
+                sl::log_fatal("Failed to poll platform messages");
 
-            frames = 0;
-            acc = 0;
+                client_state.is_running = false;
+                error_happened = true;
+            }
         }
 
-        // Poll platform messages.
-		if (!platform_poll_messages())
-		{
-			sl::log_fatal("Failed to poll platform messages");
+        // Dispatch the events queued while polling.
+        {
+            PROFILE_SCOPE("flush events");
 
-			client_state.is_running = false;
-            error_happened = true;
-		}
+            event_flush();
+        }
 
-        // Begin frame.
-        if (!renderer_begin_frame())
+        // Advance the simulation by whole ticks, unless it runs on its own thread.
+        if (!client_state.simulate_on_thread)
         {
-            sl::log_fatal("Failed to begin rendering a new frame.");
+            PROFILE_SCOPE("simulate");
+
+            uint32_t tick_count = client_state.tick_scheduler.advance(frame_time);
+
+            for (uint32_t i = 0; i < tick_count; i++)
+            {
+                uint64_t tick = client_state.tick_scheduler.tick_count - tick_count + i;
+
+                // Apply the input the recorded run had received by this tick. The run ends with the recording.
+                if (input_replay_is_active())
+                {
+                    if (!input_replay_feed(tick)) break;
+
+                    event_flush();
+                }
 
-			client_state.is_running = false;
-            error_happened = true;
+                simulate_tick(tick);
+
+                if (is_input_per_tick)
+                {
+                    input_update();
+                }
+            }
+
+            // Input received from now on arrived after these ticks.
+            input_recording_set_tick(client_state.tick_scheduler.tick_count);
+        }
+
+        SimulationState render_state = get_render_state();
+
+        // Stream chunks around the camera.
+        client_state.test_grid_streamer->update(render_state.camera_position, render_state.camera_direction);
+
+        // Keep the chunk storage in traversal order.
+        {
+            PROFILE_SCOPE("compact chunks");
+
+            client_state.test_grid.compact_step(4096);
         }
 
-        // End frame.
-        if (!renderer_end_frame())
+        if (client_state.platform_backend != PlatformBackend::HEADLESS)
         {
-            sl::log_fatal("Failed to end rendering a new frame.");
+            PROFILE_SCOPE("render");
+
+            // Begin frame.
+            if (!renderer_begin_frame())
+            {
+                sl::log_fatal("Failed to begin rendering a new frame.");
+
+                client_state.is_running = false;
+                error_happened = true;
+            }
 
-			client_state.is_running = false;
-            error_happened = true;
+            // End frame.
+            if (!renderer_end_frame())
+            {
+                sl::log_fatal("Failed to end rendering a new frame.");
+
+                client_state.is_running = false;
+                error_happened = true;
+            }
         }
 
-        input_update();
+        if (!is_input_per_tick)
+        {
+            input_update();
+        }
+
+        // Wait out the rest of the frame when the frame rate is capped.
+        if (client_state.frame_rate_limit != 0)
+        {
+            PROFILE_SCOPE("frame limiter");
+
+            uint64_t now = platform_get_time_ns();
+
+            // Frames are scheduled on a fixed grid, so the rate doesn't drift. Late frames don't make later ones
+            // shorter to catch up.
+            uint64_t frame_period = 1'000'000'000 / client_state.frame_rate_limit;
+
+            client_state.next_frame_time = std::max(client_state.next_frame_time + frame_period, now);
+
+            client_state.frame_limiter_wait_time = 0;
+
+            // Messages arriving in the meantime are handled right away, so e.g. closing the window doesn't wait for
+            // the frame to end.
+            while (client_state.is_running)
+            {
+                uint64_t wait_start_time = platform_get_time_ns();
+                bool was_woken = platform_wait_for_messages(client_state.next_frame_time);
+
+                client_state.frame_limiter_wait_time += platform_get_time_ns() - wait_start_time;
+
+                if (!was_woken) break;
+
+                if (!platform_poll_messages())
+                {
+                    sl::log_fatal("Failed to poll platform messages");
+
+                    client_state.is_running = false;
+                    error_happened = true;
+                    break;
+                }
+
+                event_flush();
+            }
+        }
     }
 
     return !error_happened;
@@ -142,10 +427,33 @@ bool client_run()
 
 void client_shutdown()
 {
-    renderer_shutdown();
+    client_state.simulation_thread.reset();
+    client_state.test_grid_streamer.reset();
+
+    // Save the chunks that are still resident.
+    for (auto& [chunk_position, octree_handle] : client_state.test_grid.octree_coordinates)
+    {
+        save_test_chunk(chunk_position, **client_state.test_grid.octrees.get(octree_handle));
+    }
+
+    client_state.test_grid_storage->flush();
+
+    if (client_state.platform_backend != PlatformBackend::HEADLESS)
+    {
+        renderer_shutdown();
+    }
+
     platform_shutdown();
+    input_recording_shutdown();
     event_shutdown();
 
+#ifdef I_PROFILE
+    profiler_export_chrome_trace("profile.json");
+#endif
+
+    frame_stats_shutdown();
+    profiler_shutdown();
+
     sl::log_info("Successfully shut down all systems.");
 }
 
@@ -153,3 +461,98 @@ void on_window_close(uint16_t event_code, EventContext ctx)
 {
 	client_state.is_running = false;
 }
+
+void simulate_tick(uint64_t tick)
+{
+    client_state.previous_simulation = client_state.simulation;
+
+    // Systems that run at the tick rate, such as voxel physics, advance `client_state.simulation` here.
+
+    // Hand the new state to rendering.
+    if (client_state.simulate_on_thread)
+    {
+        client_state.simulation_snapshots.get_write_buffer() = SimulationSnapshot {
+            client_state.previous_simulation,
+            client_state.simulation,
+            Clock::now()
+        };
+        client_state.simulation_snapshots.publish();
+    }
+}
+
+SimulationState get_render_state()
+{
+    const SimulationState* previous = &client_state.previous_simulation;
+    const SimulationState* current = &client_state.simulation;
+    float alpha = client_state.tick_scheduler.get_alpha();
+
+    if (client_state.simulate_on_thread)
+    {
+        client_state.simulation_snapshots.update();
+
+        const SimulationSnapshot& snapshot = client_state.simulation_snapshots.get_read_buffer();
+
+        previous = &snapshot.previous;
+        current = &snapshot.current;
+
+        // How far rendering is past the latest tick.
+        alpha = std::min(
+            static_cast<float>(Clock::now() - snapshot.time) / client_state.tick_scheduler.tick_duration,
+            1.0f
+        );
+    }
+
+    // Render between the last two ticks, so motion stays smooth at any frame rate.
+    SimulationState out;
+    out.camera_position = previous->camera_position + alpha * (current->camera_position - previous->camera_position);
+    out.camera_direction = previous->camera_direction + alpha * (current->camera_direction - previous->camera_direction);
+
+    return out;
+}
+
+std::optional<VoxelOctree> load_test_chunk(vector3i chunk_position, uint8_t depth)
+{
+    auto octree = client_state.test_grid_storage->load_chunk(chunk_position);
+
+    if (octree.has_value() && octree->depth == depth)
+    {
+        return octree;
+    }
+
+    return generate_test_chunk(chunk_position, depth);
+}
+
+void save_test_chunk(vector3i chunk_position, const VoxelOctree& octree)
+{
+    // Mapped octrees were never edited, so they are already stored.
+    if (octree.mapped.has_value()) return;
+
+    client_state.test_grid_storage->save_chunk(chunk_position, octree);
+}
+
+std::optional<VoxelOctree> generate_test_chunk(vector3i chunk_position, uint8_t depth)
+{
+    auto octree = VoxelOctree::create(depth);
+
+    if (!octree.has_value() || chunk_position.y != 0)
+    {
+        return octree;
+    }
+
+    uint32_t sand = *voxel_handler_get_voxel_index(voxel_id("sand"));
+    uint32_t grass = *voxel_handler_get_voxel_index(voxel_id("grass"));
+
+    // A flat checkerboard floor.
+    for (uint64_t z = 0; z < (1u << depth); z++)
+    {
+        for (uint64_t x = 0; x < (1u << depth); x++)
+        {
+            if (!octree->set_voxel(VoxelOctree::interleave_octree_coordinate(x, 0, z), (x + z) % 2 ? sand : grass))
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    return octree;
+}
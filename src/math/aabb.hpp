@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "math/float8.hpp"
+#include "math/ray.hpp"
+#include "math/vector3.hpp"
+#include "math/vector3x8.hpp"
+
+/**
+ * @brief An axis aligned bounding box.
+ */
+struct AABB
+{
+    vector3f min;
+    vector3f max;
+
+    vector3f get_center() const { return 0.5f * (min + max); }
+    vector3f get_half_extent() const { return 0.5f * (max - min); }
+
+    bool contains(const vector3f& point) const
+    {
+        return point.x >= min.x && point.y >= min.y && point.z >= min.z &&
+            point.x <= max.x && point.y <= max.y && point.z <= max.z;
+    }
+};
+
+/**
+ * @brief Eight axis aligned bounding boxes stored as structure of arrays, e.g. the children of an octree node.
+ */
+struct AABBx8
+{
+    vector3x8 min;
+    vector3x8 max;
+
+    static AABBx8 load(const AABB* boxes)
+    {
+        vector3f mins[8], maxs[8];
+
+        for (int i = 0; i < 8; i++)
+        {
+            mins[i] = boxes[i].min;
+            maxs[i] = boxes[i].max;
+        }
+
+        return AABBx8 { vector3x8::load(mins), vector3x8::load(maxs) };
+    }
+};
+
+/**
+ * @brief The distances along a ray at which it enters and exits a box.
+ */
+struct RayInterval
+{
+    float enter;
+    float exit;
+};
+
+/**
+ * @brief Intersects a ray with a box by the slab test, only counting hits at distances within [0, `t_max`].
+ *
+ * A ray starting inside the box enters it at 0.
+ */
+inline std::optional<RayInterval> ray_intersect_aabb(const Ray& ray, const AABB& box, float t_max)
+{
+    float t_enter = 0.0f;
+    float t_exit = t_max;
+
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        float t0 = (box.min[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+        float t1 = (box.max[axis] - ray.origin[axis]) * ray.inverse_direction[axis];
+
+        // A ray parallel to the slabs gets a NaN on their boundary, from 0 * infinity. The comparisons are ordered
+        // like the SIMD min and max instructions, so such rays hit or miss the same as in the 8-wide tests.
+        float t_near = t0 < t1 ? t0 : t1;
+        float t_far = t0 > t1 ? t0 : t1;
+
+        t_enter = t_near > t_enter ? t_near : t_enter;
+        t_exit = t_far < t_exit ? t_far : t_exit;
+    }
+
+    if (t_enter > t_exit)
+    {
+        return std::nullopt;
+    }
+
+    return RayInterval { t_enter, t_exit };
+}
+
+/**
+ * @brief Intersects a ray with eight boxes at once, e.g. to find the children of an octree node it passes through.
+ *
+ * @param t_enter Receives the distance at which the ray enters each box that is hit.
+ * @return The boxes that are hit, with bit `i` set for box `i`.
+ */
+inline uint8_t ray_intersect_aabb(const Ray& ray, const AABBx8& boxes, float t_max, float8& t_enter)
+{
+    vector3x8 origin = vector3x8::broadcast(ray.origin);
+    vector3x8 inverse_direction = vector3x8::broadcast(ray.inverse_direction);
+
+    vector3x8 t0 = (boxes.min - origin) * inverse_direction;
+    vector3x8 t1 = (boxes.max - origin) * inverse_direction;
+
+    // min and max return their second argument for NaN lanes, which keeps the interval so far.
+    float8 enter = max(min(t0.x, t1.x), float8::broadcast(0.0f));
+    enter = max(min(t0.y, t1.y), enter);
+    enter = max(min(t0.z, t1.z), enter);
+
+    float8 exit = min(max(t0.x, t1.x), float8::broadcast(t_max));
+    exit = min(max(t0.y, t1.y), exit);
+    exit = min(max(t0.z, t1.z), exit);
+
+    t_enter = enter;
+
+    return float8_mask_bits(enter <= exit);
+}
+
+/**
+ * @brief Intersects eight rays with a box at once, e.g. a packet of rays with a node of an acceleration structure.
+ *
+ * @param t_enter Receives the distance at which each ray that hits enters the box.
+ * @return The rays that hit, with bit `i` set for ray `i`.
+ */
+inline uint8_t ray_intersect_aabb(const Rayx8& rays, const AABB& box, const float8& t_max, float8& t_enter)
+{
+    vector3x8 t0 = (vector3x8::broadcast(box.min) - rays.origin) * rays.inverse_direction;
+    vector3x8 t1 = (vector3x8::broadcast(box.max) - rays.origin) * rays.inverse_direction;
+
+    float8 enter = max(min(t0.x, t1.x), float8::broadcast(0.0f));
+    enter = max(min(t0.y, t1.y), enter);
+    enter = max(min(t0.z, t1.z), enter);
+
+    float8 exit = min(max(t0.x, t1.x), t_max);
+    exit = min(max(t0.y, t1.y), exit);
+    exit = min(max(t0.z, t1.z), exit);
+
+    t_enter = enter;
+
+    return float8_mask_bits(enter <= exit);
+}
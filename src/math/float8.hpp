@@ -0,0 +1,270 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "math/simd.hpp"
+
+/**
+ * @brief Eight floats processed at once, in one AVX register, two SSE registers, or an array without SIMD.
+ *
+ * Comparisons return masks, which have all bits of a lane set where the comparison holds. They combine with `&` and
+ * `|`, and are consumed by \ref select and \ref float8_mask_bits.
+ */
+struct float8
+{
+#if defined(I_SIMD_AVX)
+    __m256 value;
+#elif defined(I_SIMD_SSE)
+    __m128 low;
+    __m128 high;
+#else
+    float lanes[8];
+#endif
+
+    /**
+     * @brief Sets all lanes to the same value.
+     */
+    static float8 broadcast(float v)
+    {
+#if defined(I_SIMD_AVX)
+        return float8 { _mm256_set1_ps(v) };
+#elif defined(I_SIMD_SSE)
+        return float8 { _mm_set1_ps(v), _mm_set1_ps(v) };
+#else
+        return float8 { { v, v, v, v, v, v, v, v } };
+#endif
+    }
+
+    static float8 load(const float* values)
+    {
+#if defined(I_SIMD_AVX)
+        return float8 { _mm256_loadu_ps(values) };
+#elif defined(I_SIMD_SSE)
+        return float8 { _mm_loadu_ps(values), _mm_loadu_ps(values + 4) };
+#else
+        float8 out;
+        for (int i = 0; i < 8; i++) out.lanes[i] = values[i];
+
+        return out;
+#endif
+    }
+
+    void store(float* values) const
+    {
+#if defined(I_SIMD_AVX)
+        _mm256_storeu_ps(values, value);
+#elif defined(I_SIMD_SSE)
+        _mm_storeu_ps(values, low);
+        _mm_storeu_ps(values + 4, high);
+#else
+        for (int i = 0; i < 8; i++) values[i] = lanes[i];
+#endif
+    }
+};
+
+inline float8 operator + (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_add_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_add_ps(l.low, r.low), _mm_add_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] + r.lanes[i];
+
+    return out;
+#endif
+}
+
+inline float8 operator - (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_sub_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_sub_ps(l.low, r.low), _mm_sub_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] - r.lanes[i];
+
+    return out;
+#endif
+}
+
+inline float8 operator * (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_mul_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_mul_ps(l.low, r.low), _mm_mul_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] * r.lanes[i];
+
+    return out;
+#endif
+}
+
+inline float8 operator / (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_div_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_div_ps(l.low, r.low), _mm_div_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] / r.lanes[i];
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Returns `r` in lanes where either is NaN, like the SIMD instructions.
+ */
+inline float8 min(const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_min_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_min_ps(l.low, r.low), _mm_min_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] < r.lanes[i] ? l.lanes[i] : r.lanes[i];
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Returns `r` in lanes where either is NaN, like the SIMD instructions.
+ */
+inline float8 max(const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_max_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_max_ps(l.low, r.low), _mm_max_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = l.lanes[i] > r.lanes[i] ? l.lanes[i] : r.lanes[i];
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Compares lanes, false where either is NaN.
+ */
+inline float8 operator < (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_cmp_ps(l.value, r.value, _CMP_LT_OQ) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_cmplt_ps(l.low, r.low), _mm_cmplt_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = std::bit_cast<float>(l.lanes[i] < r.lanes[i] ? ~0u : 0u);
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Compares lanes, false where either is NaN.
+ */
+inline float8 operator <= (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_cmp_ps(l.value, r.value, _CMP_LE_OQ) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_cmple_ps(l.low, r.low), _mm_cmple_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = std::bit_cast<float>(l.lanes[i] <= r.lanes[i] ? ~0u : 0u);
+
+    return out;
+#endif
+}
+
+inline float8 operator > (const float8& l, const float8& r)
+{
+    return r < l;
+}
+
+inline float8 operator >= (const float8& l, const float8& r)
+{
+    return r <= l;
+}
+
+inline float8 operator & (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_and_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_and_ps(l.low, r.low), _mm_and_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++)
+    {
+        out.lanes[i] = std::bit_cast<float>(std::bit_cast<uint32_t>(l.lanes[i]) & std::bit_cast<uint32_t>(r.lanes[i]));
+    }
+
+    return out;
+#endif
+}
+
+inline float8 operator | (const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_or_ps(l.value, r.value) };
+#elif defined(I_SIMD_SSE)
+    return float8 { _mm_or_ps(l.low, r.low), _mm_or_ps(l.high, r.high) };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++)
+    {
+        out.lanes[i] = std::bit_cast<float>(std::bit_cast<uint32_t>(l.lanes[i]) | std::bit_cast<uint32_t>(r.lanes[i]));
+    }
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Picks the lanes of `l` where the mask is set, and of `r` elsewhere.
+ */
+inline float8 select(const float8& mask, const float8& l, const float8& r)
+{
+#if defined(I_SIMD_AVX)
+    return float8 { _mm256_blendv_ps(r.value, l.value, mask.value) };
+#elif defined(I_SIMD_SSE)
+    // SSE2 has no blend, so combine the masked halves instead.
+    return float8 {
+        _mm_or_ps(_mm_and_ps(mask.low, l.low), _mm_andnot_ps(mask.low, r.low)),
+        _mm_or_ps(_mm_and_ps(mask.high, l.high), _mm_andnot_ps(mask.high, r.high))
+    };
+#else
+    float8 out;
+    for (int i = 0; i < 8; i++) out.lanes[i] = std::bit_cast<uint32_t>(mask.lanes[i]) ? l.lanes[i] : r.lanes[i];
+
+    return out;
+#endif
+}
+
+/**
+ * @brief Packs a mask into a byte, with bit `i` set if lane `i` is.
+ */
+inline uint8_t float8_mask_bits(const float8& mask)
+{
+#if defined(I_SIMD_AVX)
+    return static_cast<uint8_t>(_mm256_movemask_ps(mask.value));
+#elif defined(I_SIMD_SSE)
+    return static_cast<uint8_t>(_mm_movemask_ps(mask.low) | (_mm_movemask_ps(mask.high) << 4));
+#else
+    uint8_t out = 0;
+    for (int i = 0; i < 8; i++) out |= (std::bit_cast<uint32_t>(mask.lanes[i]) >> 31) << i;
+
+    return out;
+#endif
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "math/aabb.hpp"
+#include "math/float8.hpp"
+#include "math/matrix4.hpp"
+#include "math/vector3x8.hpp"
+#include "math/vector4.hpp"
+
+enum class FrustumClassification
+{
+    OUTSIDE,
+    INTERSECTING,
+    INSIDE
+};
+
+/**
+ * @brief The classifications of eight boxes, with bit `i` set for box `i`. Boxes in neither mask intersect the frustum.
+ */
+struct FrustumClassificationx8
+{
+    uint8_t outside;
+    uint8_t inside;
+};
+
+/**
+ * @brief The volume visible through a camera, bounded by six planes.
+ */
+struct Frustum
+{
+    // Left, right, bottom, top, near and far. `xyz` is the unit normal pointing inwards and `w` the distance, so a
+    // point `p` is on the inner side where `dot(xyz, p) + w >= 0`.
+    vector4f planes[6];
+
+    /**
+     * @brief Extracts the planes of a view projection matrix with Vulkan clip space, where depth goes from 0 to 1.
+     *
+     * With a projection matrix alone, the planes are in view space. With a view projection matrix, in world space.
+     */
+    static Frustum from_matrix(const matrix4f& m)
+    {
+        // Clip space bounds are planes on the rows of the matrix, e.g. x >= -w for the left plane.
+        auto row = [&m](int i) { return vector4f { m[0][i], m[1][i], m[2][i], m[3][i] }; };
+
+        Frustum out {{
+            row(3) + row(0),
+            row(3) - row(0),
+            row(3) + row(1),
+            row(3) - row(1),
+            row(2),
+            row(3) - row(2)
+        }};
+
+        for (vector4f& plane : out.planes)
+        {
+            plane /= length(plane.xyz());
+        }
+
+        return out;
+    }
+};
+
+/**
+ * @brief Classifies a box against a frustum. Conservative, so boxes near the corners of the frustum may be classified
+ * as intersecting although they are outside.
+ */
+inline FrustumClassification frustum_classify_aabb(const Frustum& frustum, const AABB& box)
+{
+    vector3f center = box.get_center();
+    vector3f half_extent = box.get_half_extent();
+
+    FrustumClassification out = FrustumClassification::INSIDE;
+
+    for (const vector4f& plane : frustum.planes)
+    {
+        // The distance of the center to the plane, and the furthest any corner reaches towards the plane.
+        float distance = dot(plane.xyz(), center) + plane.w;
+        float radius = std::abs(plane.x) * half_extent.x + std::abs(plane.y) * half_extent.y +
+            std::abs(plane.z) * half_extent.z;
+
+        if (distance < -radius)
+        {
+            return FrustumClassification::OUTSIDE;
+        }
+
+        if (distance < radius)
+        {
+            out = FrustumClassification::INTERSECTING;
+        }
+    }
+
+    return out;
+}
+
+/**
+ * @brief Classifies eight boxes against a frustum at once, like \ref frustum_classify_aabb.
+ */
+inline FrustumClassificationx8 frustum_classify_aabb(const Frustum& frustum, const AABBx8& boxes)
+{
+    float8 half = float8::broadcast(0.5f);
+
+    vector3x8 center = half * (boxes.min + boxes.max);
+    vector3x8 half_extent = half * (boxes.max - boxes.min);
+
+    float8 outside = float8::broadcast(0.0f);
+    float8 intersecting = float8::broadcast(0.0f);
+
+    for (const vector4f& plane : frustum.planes)
+    {
+        vector3x8 normal = vector3x8::broadcast(plane.xyz());
+        vector3x8 abs_normal = vector3x8::broadcast(
+            vector3f { std::abs(plane.x), std::abs(plane.y), std::abs(plane.z) });
+
+        float8 distance = dot(normal, center) + float8::broadcast(plane.w);
+        float8 radius = dot(abs_normal, half_extent);
+
+        outside = outside | (distance < float8::broadcast(0.0f) - radius);
+        intersecting = intersecting | (distance < radius);
+    }
+
+    uint8_t outside_bits = float8_mask_bits(outside);
+
+    return FrustumClassificationx8 {
+        outside_bits,
+        static_cast<uint8_t>(~float8_mask_bits(intersecting) & ~outside_bits)
+    };
+}
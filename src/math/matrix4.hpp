@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "math/arithmetic.hpp"
+#include "math/quaternion.hpp"
+#include "math/simd.hpp"
+#include "math/vector3.hpp"
+#include "math/vector4.hpp"
+
+/**
+ * @brief A 4x4 matrix in column major order, like GLSL expects it.
+ *
+ * Matrices transform column vectors, so `a * b` applies `b` first.
+ */
+template<arithmetic A>
+struct matrix4
+{
+    vector4<A> columns[4];
+
+    constexpr vector4<A>& operator [] (size_t column) { return columns[column]; }
+    constexpr const vector4<A>& operator [] (size_t column) const { return columns[column]; }
+
+    static constexpr matrix4 identity()
+    {
+        return matrix4 {{
+            { 1, 0, 0, 0 },
+            { 0, 1, 0, 0 },
+            { 0, 0, 1, 0 },
+            { 0, 0, 0, 1 }
+        }};
+    }
+
+    static constexpr matrix4 translation(const vector3<A>& offset)
+    {
+        matrix4 out = identity();
+        out.columns[3] = vector4<A> { offset.x, offset.y, offset.z, 1 };
+
+        return out;
+    }
+
+    static constexpr matrix4 scale(const vector3<A>& factors)
+    {
+        return matrix4 {{
+            { factors.x, 0, 0, 0 },
+            { 0, factors.y, 0, 0 },
+            { 0, 0, factors.z, 0 },
+            { 0, 0, 0, 1 }
+        }};
+    }
+
+    /**
+     * @brief Builds the rotation of a unit quaternion.
+     */
+    static constexpr matrix4 rotation(const quaternion<A>& q)
+    {
+        A xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        A xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        A wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        return matrix4 {{
+            { 1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0 },
+            { 2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0 },
+            { 2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0 },
+            { 0, 0, 0, 1 }
+        }};
+    }
+
+    /**
+     * @brief Projects a right-handed view space looking down -z into Vulkan clip space, where y points down and depth
+     * goes from 0 at the near plane to 1 at the far plane.
+     *
+     * @param vertical_fov In radians.
+     */
+    static matrix4 perspective(A vertical_fov, A aspect_ratio, A near, A far)
+        requires std::floating_point<A>
+    {
+        A focal_length = 1 / std::tan(vertical_fov / 2);
+
+        return matrix4 {{
+            { focal_length / aspect_ratio, 0, 0, 0 },
+            { 0, -focal_length, 0, 0 },
+            { 0, 0, far / (near - far), -1 },
+            { 0, 0, near * far / (near - far), 0 }
+        }};
+    }
+
+    /**
+     * @brief Builds the view matrix of a camera at `eye` looking at `target`. `up` must not be parallel to the view
+     * direction.
+     */
+    static matrix4 look_at(const vector3<A>& eye, const vector3<A>& target, const vector3<A>& up)
+        requires std::floating_point<A>
+    {
+        vector3<A> forward = normalize(target - eye);
+        vector3<A> right = normalize(cross(forward, up));
+        vector3<A> camera_up = cross(right, forward);
+
+        return matrix4 {{
+            { right.x, camera_up.x, -forward.x, 0 },
+            { right.y, camera_up.y, -forward.y, 0 },
+            { right.z, camera_up.z, -forward.z, 0 },
+            { -dot(right, eye), -dot(camera_up, eye), dot(forward, eye), 1 }
+        }};
+    }
+};
+
+template<arithmetic A>
+constexpr bool operator == (const matrix4<A>& l, const matrix4<A>& r)
+{
+    return l[0] == r[0] && l[1] == r[1] && l[2] == r[2] && l[3] == r[3];
+}
+
+template<arithmetic A>
+constexpr vector4<A> operator * (const matrix4<A>& l, const vector4<A>& r)
+{
+    return r.x * l[0] + r.y * l[1] + r.z * l[2] + r.w * l[3];
+}
+
+template<arithmetic A>
+constexpr matrix4<A> operator * (const matrix4<A>& l, const matrix4<A>& r)
+{
+    return matrix4<A> {{ l * r[0], l * r[1], l * r[2], l * r[3] }};
+}
+
+/**
+ * @brief Transforms a point, i.e. a vector with a w of 1 that is affected by translation.
+ *
+ * Does not divide by the resulting w, so only use it with affine matrices.
+ */
+template<arithmetic A>
+constexpr vector3<A> transform_point(const matrix4<A>& m, const vector3<A>& p)
+{
+    return (m * vector4<A> { p.x, p.y, p.z, 1 }).xyz();
+}
+
+/**
+ * @brief Transforms a direction, i.e. a vector with a w of 0 that is not affected by translation.
+ */
+template<arithmetic A>
+constexpr vector3<A> transform_direction(const matrix4<A>& m, const vector3<A>& d)
+{
+    return (m * vector4<A> { d.x, d.y, d.z, 0 }).xyz();
+}
+
+template<arithmetic A>
+constexpr matrix4<A> transpose(const matrix4<A>& m)
+{
+    return matrix4<A> {{
+        { m[0].x, m[1].x, m[2].x, m[3].x },
+        { m[0].y, m[1].y, m[2].y, m[3].y },
+        { m[0].z, m[1].z, m[2].z, m[3].z },
+        { m[0].w, m[1].w, m[2].w, m[3].w }
+    }};
+}
+
+/**
+ * @brief Returns the inverse of an invertible matrix, by cofactor expansion.
+ */
+template<std::floating_point A>
+constexpr matrix4<A> inverse(const matrix4<A>& m)
+{
+    // The 2x2 determinants of the top two and bottom two rows, shared by the cofactors.
+    A s0 = m[0].x * m[1].y - m[1].x * m[0].y;
+    A s1 = m[0].x * m[2].y - m[2].x * m[0].y;
+    A s2 = m[0].x * m[3].y - m[3].x * m[0].y;
+    A s3 = m[1].x * m[2].y - m[2].x * m[1].y;
+    A s4 = m[1].x * m[3].y - m[3].x * m[1].y;
+    A s5 = m[2].x * m[3].y - m[3].x * m[2].y;
+
+    A c5 = m[2].z * m[3].w - m[3].z * m[2].w;
+    A c4 = m[1].z * m[3].w - m[3].z * m[1].w;
+    A c3 = m[1].z * m[2].w - m[2].z * m[1].w;
+    A c2 = m[0].z * m[3].w - m[3].z * m[0].w;
+    A c1 = m[0].z * m[2].w - m[2].z * m[0].w;
+    A c0 = m[0].z * m[1].w - m[1].z * m[0].w;
+
+    A inverse_determinant = 1 / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    matrix4<A> out {{
+        {
+            ( m[1].y * c5 - m[2].y * c4 + m[3].y * c3),
+            (-m[0].y * c5 + m[2].y * c2 - m[3].y * c1),
+            ( m[0].y * c4 - m[1].y * c2 + m[3].y * c0),
+            (-m[0].y * c3 + m[1].y * c1 - m[2].y * c0)
+        },
+        {
+            (-m[1].x * c5 + m[2].x * c4 - m[3].x * c3),
+            ( m[0].x * c5 - m[2].x * c2 + m[3].x * c1),
+            (-m[0].x * c4 + m[1].x * c2 - m[3].x * c0),
+            ( m[0].x * c3 - m[1].x * c1 + m[2].x * c0)
+        },
+        {
+            ( m[1].w * s5 - m[2].w * s4 + m[3].w * s3),
+            (-m[0].w * s5 + m[2].w * s2 - m[3].w * s1),
+            ( m[0].w * s4 - m[1].w * s2 + m[3].w * s0),
+            (-m[0].w * s3 + m[1].w * s1 - m[2].w * s0)
+        },
+        {
+            (-m[1].z * s5 + m[2].z * s4 - m[3].z * s3),
+            ( m[0].z * s5 - m[2].z * s2 + m[3].z * s1),
+            (-m[0].z * s4 + m[1].z * s2 - m[3].z * s0),
+            ( m[0].z * s3 - m[1].z * s1 + m[2].z * s0)
+        }
+    }};
+
+    for (vector4<A>& column : out.columns)
+    {
+        column *= inverse_determinant;
+    }
+
+    return out;
+}
+
+typedef matrix4<float> matrix4f;
+typedef matrix4<double> matrix4d;
+
+#ifdef I_SIMD_SSE
+// Matrix products are built from this one, so they use SSE as well.
+
+constexpr vector4f operator * (const matrix4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator *<float>(l, r);
+
+    __m128 v = vector4_load(r);
+
+    __m128 out = _mm_mul_ps(vector4_load(l[0]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    out = _mm_add_ps(out, _mm_mul_ps(vector4_load(l[1]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    out = _mm_add_ps(out, _mm_mul_ps(vector4_load(l[2]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    out = _mm_add_ps(out, _mm_mul_ps(vector4_load(l[3]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+
+    return vector4_store(out);
+}
+#endif
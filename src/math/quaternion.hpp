@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cmath>
+
+#include "math/arithmetic.hpp"
+#include "math/vector3.hpp"
+
+/**
+ * @brief A rotation. Unit length, unless built by hand.
+ */
+template<arithmetic A>
+struct quaternion
+{
+    // The rotation axis, scaled by the sine of half the angle.
+    A x = 0;
+    A y = 0;
+    A z = 0;
+
+    // The cosine of half the angle.
+    A w = 1;
+
+    static constexpr quaternion identity() { return quaternion {}; }
+
+    /**
+     * @brief Rotates counter-clockwise by `angle` radians when looking down the unit length `axis`.
+     */
+    static quaternion from_axis_angle(const vector3<A>& axis, A angle)
+    {
+        A s = std::sin(angle / 2);
+
+        return quaternion { axis.x * s, axis.y * s, axis.z * s, std::cos(angle / 2) };
+    }
+};
+
+template<arithmetic A>
+constexpr bool operator == (const quaternion<A>& l, const quaternion<A>& r)
+{
+    return l.x == r.x && l.y == r.y && l.z == r.z && l.w == r.w;
+}
+
+/**
+ * @brief Combines two rotations, rotating by `r` first and by `l` second.
+ */
+template<arithmetic A>
+constexpr quaternion<A> operator * (const quaternion<A>& l, const quaternion<A>& r)
+{
+    return quaternion<A> {
+        l.w * r.x + l.x * r.w + l.y * r.z - l.z * r.y,
+        l.w * r.y - l.x * r.z + l.y * r.w + l.z * r.x,
+        l.w * r.z + l.x * r.y - l.y * r.x + l.z * r.w,
+        l.w * r.w - l.x * r.x - l.y * r.y - l.z * r.z
+    };
+}
+
+/**
+ * @brief Returns the opposite rotation of a unit quaternion.
+ */
+template<arithmetic A>
+constexpr quaternion<A> conjugate(const quaternion<A>& q)
+{
+    return quaternion<A> { -q.x, -q.y, -q.z, q.w };
+}
+
+template<arithmetic A>
+constexpr A dot(const quaternion<A>& l, const quaternion<A>& r)
+{
+    return l.x * r.x + l.y * r.y + l.z * r.z + l.w * r.w;
+}
+
+template<std::floating_point A>
+quaternion<A> normalize(const quaternion<A>& q)
+{
+    A inverse_length = 1 / std::sqrt(dot(q, q));
+
+    return quaternion<A> { q.x * inverse_length, q.y * inverse_length, q.z * inverse_length, q.w * inverse_length };
+}
+
+/**
+ * @brief Rotates a vector by a unit quaternion.
+ */
+template<arithmetic A>
+constexpr vector3<A> rotate(const quaternion<A>& q, const vector3<A>& v)
+{
+    // v + 2w(u x v) + 2u x (u x v), without building the matrix.
+    vector3<A> u { q.x, q.y, q.z };
+    vector3<A> t = A(2) * cross(u, v);
+
+    return v + q.w * t + cross(u, t);
+}
+
+/**
+ * @brief Interpolates along the shortest arc between two unit quaternions at a constant angular rate.
+ */
+template<std::floating_point A>
+quaternion<A> slerp(const quaternion<A>& l, quaternion<A> r, A t)
+{
+    A cos_angle = dot(l, r);
+
+    // `r` and `-r` are the same rotation. Take the one closer to `l`.
+    if (cos_angle < 0)
+    {
+        r = quaternion<A> { -r.x, -r.y, -r.z, -r.w };
+        cos_angle = -cos_angle;
+    }
+
+    A l_weight = 1 - t;
+    A r_weight = t;
+
+    // Nearly parallel quaternions divide by a sine close to 0, so interpolate linearly instead.
+    if (cos_angle < A(0.9995))
+    {
+        A angle = std::acos(cos_angle);
+        A inverse_sin = 1 / std::sin(angle);
+
+        l_weight = std::sin((1 - t) * angle) * inverse_sin;
+        r_weight = std::sin(t * angle) * inverse_sin;
+    }
+
+    return normalize(quaternion<A> {
+        l_weight * l.x + r_weight * r.x,
+        l_weight * l.y + r_weight * r.y,
+        l_weight * l.z + r_weight * r.z,
+        l_weight * l.w + r_weight * r.w
+    });
+}
+
+typedef quaternion<float> quaternionf;
+typedef quaternion<double> quaterniond;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+#include "math/vector3.hpp"
+#include "math/vector3x8.hpp"
+
+struct Ray
+{
+    vector3f origin;
+    vector3f direction;
+
+    // 1 / direction, used by the slab tests. Infinite along axes the ray is parallel to.
+    vector3f inverse_direction;
+
+    static Ray create(const vector3f& origin, const vector3f& direction)
+    {
+        return Ray { origin, direction, vector3f { 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z } };
+    }
+
+    vector3f at(float t) const { return origin + t * direction; }
+
+    /**
+     * @brief Returns the axes the direction is negative along, with bit 0, 1 and 2 set for x, y and z.
+     */
+    uint8_t get_octant_mask() const
+    {
+        return (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0) | (direction.z < 0.0f ? 4 : 0);
+    }
+};
+
+/**
+ * @brief Returns the `i`th child of an octree node to visit when walking front to back along a ray.
+ *
+ * Children are indexed like octree branches, with bit 0, 1 and 2 set for the upper half along x, y and z. A ray only
+ * ever moves from a child into one with more bits set after flipping the bits of its octant mask, so visiting in this
+ * order finds the nearest hit first and can stop there.
+ *
+ * @param octant_mask See \ref Ray::get_octant_mask.
+ */
+constexpr uint8_t ray_get_child_order(uint8_t octant_mask, uint8_t i)
+{
+    return i ^ octant_mask;
+}
+
+/**
+ * @brief Eight rays stored as structure of arrays, e.g. a packet of neighbouring pixels.
+ */
+struct Rayx8
+{
+    vector3x8 origin;
+    vector3x8 direction;
+    vector3x8 inverse_direction;
+
+    static Rayx8 load(const Ray* rays)
+    {
+        vector3f origins[8], directions[8], inverse_directions[8];
+
+        for (int i = 0; i < 8; i++)
+        {
+            origins[i] = rays[i].origin;
+            directions[i] = rays[i].direction;
+            inverse_directions[i] = rays[i].inverse_direction;
+        }
+
+        return Rayx8 {
+            vector3x8::load(origins),
+            vector3x8::load(directions),
+            vector3x8::load(inverse_directions)
+        };
+    }
+};
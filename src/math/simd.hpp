@@ -0,0 +1,13 @@
+#pragma once
+
+// SSE2 is part of x86-64, so it is always available there. AVX only when the compiler targets it, e.g. with the
+// INDUSTRIA_AVX2 CMake option.
+#if defined(__SSE2__) || defined(__x86_64__) || defined(_M_X64)
+#define I_SIMD_SSE
+
+#ifdef __AVX__
+#define I_SIMD_AVX
+#endif
+
+#include <immintrin.h>
+#endif
@@ -1,20 +1,124 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
 #include "math/arithmetic.hpp"
 
 template<arithmetic A>
 struct vector2
 {
-    union { A x, s, u, w; };
-    union { A y, t, v, h; };
+    union { A x = 0, s, u, w; };
+    union { A y = 0, t, v, h; };
+
+    constexpr A& operator [] (size_t i) { return i == 0 ? x : y; }
+    constexpr const A& operator [] (size_t i) const { return i == 0 ? x : y; }
+
+    constexpr vector2& operator += (const vector2& r) { x += r.x; y += r.y; return *this; }
+    constexpr vector2& operator -= (const vector2& r) { x -= r.x; y -= r.y; return *this; }
+    constexpr vector2& operator *= (A r) { x *= r; y *= r; return *this; }
+    constexpr vector2& operator /= (A r) { x /= r; y /= r; return *this; }
 };
 
 template <arithmetic A>
-bool operator == (const vector2<A>& l, const vector2<A>& r)
+constexpr bool operator == (const vector2<A>& l, const vector2<A>& r)
 {
     return l.x == r.x && l.y == r.y;
 }
 
+template<arithmetic A>
+constexpr vector2<A> operator - (const vector2<A>& v)
+{
+    return vector2<A> { -v.x, -v.y };
+}
+
+template<arithmetic A>
+constexpr vector2<A> operator + (const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { l.x + r.x, l.y + r.y };
+}
+
+template<arithmetic A>
+constexpr vector2<A> operator - (const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { l.x - r.x, l.y - r.y };
+}
+
+/**
+ * @brief Multiplies component-wise.
+ */
+template<arithmetic A>
+constexpr vector2<A> operator * (const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { l.x * r.x, l.y * r.y };
+}
+
+template<arithmetic A>
+constexpr vector2<A> operator * (A l, const vector2<A>& r)
+{
+    return vector2<A> { l * r.x, l * r.y };
+}
+
+template<arithmetic A>
+constexpr vector2<A> operator * (const vector2<A>& l, A r)
+{
+    return vector2<A> { l.x * r, l.y * r };
+}
+
+/**
+ * @brief Divides component-wise.
+ */
+template<arithmetic A>
+constexpr vector2<A> operator / (const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { l.x / r.x, l.y / r.y };
+}
+
+template<arithmetic A>
+constexpr vector2<A> operator / (const vector2<A>& l, A r)
+{
+    return vector2<A> { l.x / r, l.y / r };
+}
+
+template<arithmetic A>
+constexpr A dot(const vector2<A>& l, const vector2<A>& r)
+{
+    return l.x * r.x + l.y * r.y;
+}
+
+template<arithmetic A>
+constexpr A length_squared(const vector2<A>& v)
+{
+    return dot(v, v);
+}
+
+template<std::floating_point A>
+A length(const vector2<A>& v)
+{
+    return std::sqrt(length_squared(v));
+}
+
+/**
+ * @brief Returns the vector scaled to a length of 1. The vector must not be zero.
+ */
+template<std::floating_point A>
+vector2<A> normalize(const vector2<A>& v)
+{
+    return v / length(v);
+}
+
+template<arithmetic A>
+constexpr vector2<A> min(const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { std::min(l.x, r.x), std::min(l.y, r.y) };
+}
+
+template<arithmetic A>
+constexpr vector2<A> max(const vector2<A>& l, const vector2<A>& r)
+{
+    return vector2<A> { std::max(l.x, r.x), std::max(l.y, r.y) };
+}
 
 typedef vector2<int> vector2i;
 typedef vector2<unsigned int> vector2ui;
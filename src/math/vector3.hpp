@@ -1,26 +1,46 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+
 #include "math/arithmetic.hpp"
 
-// Pre-define friend-template functions so the compiler knows they're templated.
-template <arithmetic A> struct vector3;
-template <arithmetic A> bool operator == (const vector3<A>& l, const vector3<A>& r)
+template<arithmetic A>
+struct vector3
+{
+    union { A x = 0, r; };
+    union { A y = 0, g; };
+    union { A z = 0, b; };
+
+    constexpr A& operator [] (size_t i) { return i == 0 ? x : i == 1 ? y : z; }
+    constexpr const A& operator [] (size_t i) const { return i == 0 ? x : i == 1 ? y : z; }
+
+    constexpr vector3& operator += (const vector3& o) { x += o.x; y += o.y; z += o.z; return *this; }
+    constexpr vector3& operator -= (const vector3& o) { x -= o.x; y -= o.y; z -= o.z; return *this; }
+    constexpr vector3& operator *= (A o) { x *= o; y *= o; z *= o; return *this; }
+    constexpr vector3& operator /= (A o) { x /= o; y /= o; z /= o; return *this; }
+};
+
+template <arithmetic A>
+constexpr bool operator == (const vector3<A>& l, const vector3<A>& r)
 {
     return l.x == r.x && l.y == r.y && l.z == r.z;
 }
 
 template<arithmetic A>
-struct vector3
+constexpr vector3<A> operator - (const vector3<A>& v)
 {
-    union { A x, r = 0; };
-    union { A y, g = 0; };
-    union { A z, b = 0; };
-
-    friend bool operator ==<> (const vector3<A>& l, const vector3<A>& r);
-};
+    return vector3<A> {
+        -v.x,
+        -v.y,
+        -v.z
+    };
+}
 
 template<arithmetic A>
-vector3<A> operator - (const vector3<A>& l, const vector3<A>& r)
+constexpr vector3<A> operator - (const vector3<A>& l, const vector3<A>& r)
 {
     return vector3<A> {
         l.x - r.x,
@@ -30,7 +50,7 @@ vector3<A> operator - (const vector3<A>& l, const vector3<A>& r)
 }
 
 template<arithmetic A>
-vector3<A> operator + (const vector3<A>& l, const vector3<A>& r)
+constexpr vector3<A> operator + (const vector3<A>& l, const vector3<A>& r)
 {
     return vector3<A> {
         l.x + r.x,
@@ -39,8 +59,21 @@ vector3<A> operator + (const vector3<A>& l, const vector3<A>& r)
     };
 }
 
+/**
+ * @brief Multiplies component-wise.
+ */
+template<arithmetic A>
+constexpr vector3<A> operator * (const vector3<A>& l, const vector3<A>& r)
+{
+    return vector3<A> {
+        l.x * r.x,
+        l.y * r.y,
+        l.z * r.z
+    };
+}
+
 template<arithmetic A>
-vector3<A> operator * (A l, const vector3<A>& r)
+constexpr vector3<A> operator * (A l, const vector3<A>& r)
 {
     return vector3<A> {
         l * r.x,
@@ -50,7 +83,26 @@ vector3<A> operator * (A l, const vector3<A>& r)
 }
 
 template<arithmetic A>
-vector3<A> operator / (const vector3<A>& l, A r)
+constexpr vector3<A> operator * (const vector3<A>& l, A r)
+{
+    return r * l;
+}
+
+/**
+ * @brief Divides component-wise.
+ */
+template<arithmetic A>
+constexpr vector3<A> operator / (const vector3<A>& l, const vector3<A>& r)
+{
+    return vector3<A> {
+        l.x / r.x,
+        l.y / r.y,
+        l.z / r.z
+    };
+}
+
+template<arithmetic A>
+constexpr vector3<A> operator / (const vector3<A>& l, A r)
 {
     return vector3<A> {
         l.x / r,
@@ -60,7 +112,7 @@ vector3<A> operator / (const vector3<A>& l, A r)
 }
 
 template<arithmetic A>
-vector3<A> operator % (const vector3<A>& l, A r)
+constexpr vector3<A> operator % (const vector3<A>& l, A r)
 {
     return vector3<A> {
         l.x % r,
@@ -69,6 +121,89 @@ vector3<A> operator % (const vector3<A>& l, A r)
     };
 }
 
+template<arithmetic A>
+constexpr A dot(const vector3<A>& l, const vector3<A>& r)
+{
+    return l.x * r.x + l.y * r.y + l.z * r.z;
+}
+
+/**
+ * @brief Returns the vector perpendicular to both, by the right hand rule.
+ */
+template<arithmetic A>
+constexpr vector3<A> cross(const vector3<A>& l, const vector3<A>& r)
+{
+    return vector3<A> {
+        l.y * r.z - l.z * r.y,
+        l.z * r.x - l.x * r.z,
+        l.x * r.y - l.y * r.x
+    };
+}
+
+template<arithmetic A>
+constexpr A length_squared(const vector3<A>& v)
+{
+    return dot(v, v);
+}
+
+template<std::floating_point A>
+A length(const vector3<A>& v)
+{
+    return std::sqrt(length_squared(v));
+}
+
+/**
+ * @brief Returns the vector scaled to a length of 1. The vector must not be zero.
+ */
+template<std::floating_point A>
+vector3<A> normalize(const vector3<A>& v)
+{
+    return v / length(v);
+}
+
+template<arithmetic A>
+constexpr vector3<A> min(const vector3<A>& l, const vector3<A>& r)
+{
+    return vector3<A> {
+        std::min(l.x, r.x),
+        std::min(l.y, r.y),
+        std::min(l.z, r.z)
+    };
+}
+
+template<arithmetic A>
+constexpr vector3<A> max(const vector3<A>& l, const vector3<A>& r)
+{
+    return vector3<A> {
+        std::max(l.x, r.x),
+        std::max(l.y, r.y),
+        std::max(l.z, r.z)
+    };
+}
+
+/**
+ * @brief Interpolates linearly, returning `l` at `t = 0` and `r` at `t = 1`.
+ */
+template<std::floating_point A>
+constexpr vector3<A> lerp(const vector3<A>& l, const vector3<A>& r, A t)
+{
+    return l + t * (r - l);
+}
+
+template<arithmetic A>
+struct std::hash<vector3<A>>
+{
+    size_t operator () (const vector3<A>& v) const noexcept
+    {
+        size_t h = std::hash<A>{}(v.x);
+
+        h ^= std::hash<A>{}(v.y) + 0x9E37'79B9'7F4A'7C15 + (h << 6) + (h >> 2);
+        h ^= std::hash<A>{}(v.z) + 0x9E37'79B9'7F4A'7C15 + (h << 6) + (h >> 2);
+
+        return h;
+    }
+};
+
 typedef vector3<int> vector3i;
 typedef vector3<float> vector3f;
 typedef vector3<double> vector3d;
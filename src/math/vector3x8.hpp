@@ -0,0 +1,148 @@
+#pragma once
+
+#include "math/float8.hpp"
+#include "math/matrix4.hpp"
+#include "math/vector3.hpp"
+
+/**
+ * @brief Eight float vectors stored as structure of arrays, so every operation processes all eight at once, e.g. a
+ * packet of rays or a batch of points to transform.
+ */
+struct vector3x8
+{
+    float8 x;
+    float8 y;
+    float8 z;
+
+    /**
+     * @brief Sets all eight vectors to the same one.
+     */
+    static vector3x8 broadcast(const vector3f& v)
+    {
+        return vector3x8 { float8::broadcast(v.x), float8::broadcast(v.y), float8::broadcast(v.z) };
+    }
+
+    /**
+     * @brief Transposes eight vectors into lanes.
+     */
+    static vector3x8 load(const vector3f* vectors)
+    {
+        alignas(32) float xs[8], ys[8], zs[8];
+
+        for (int i = 0; i < 8; i++)
+        {
+            xs[i] = vectors[i].x;
+            ys[i] = vectors[i].y;
+            zs[i] = vectors[i].z;
+        }
+
+        return vector3x8 { float8::load(xs), float8::load(ys), float8::load(zs) };
+    }
+
+    /**
+     * @brief Transposes the lanes back into eight vectors.
+     */
+    void store(vector3f* vectors) const
+    {
+        alignas(32) float xs[8], ys[8], zs[8];
+
+        x.store(xs);
+        y.store(ys);
+        z.store(zs);
+
+        for (int i = 0; i < 8; i++)
+        {
+            vectors[i] = vector3f { xs[i], ys[i], zs[i] };
+        }
+    }
+};
+
+inline vector3x8 operator + (const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { l.x + r.x, l.y + r.y, l.z + r.z };
+}
+
+inline vector3x8 operator - (const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { l.x - r.x, l.y - r.y, l.z - r.z };
+}
+
+/**
+ * @brief Multiplies component-wise.
+ */
+inline vector3x8 operator * (const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { l.x * r.x, l.y * r.y, l.z * r.z };
+}
+
+/**
+ * @brief Scales every vector by its lane of `l`.
+ */
+inline vector3x8 operator * (const float8& l, const vector3x8& r)
+{
+    return vector3x8 { l * r.x, l * r.y, l * r.z };
+}
+
+inline float8 dot(const vector3x8& l, const vector3x8& r)
+{
+    return l.x * r.x + l.y * r.y + l.z * r.z;
+}
+
+inline vector3x8 cross(const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 {
+        l.y * r.z - l.z * r.y,
+        l.z * r.x - l.x * r.z,
+        l.x * r.y - l.y * r.x
+    };
+}
+
+inline float8 length_squared(const vector3x8& v)
+{
+    return dot(v, v);
+}
+
+inline vector3x8 min(const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { min(l.x, r.x), min(l.y, r.y), min(l.z, r.z) };
+}
+
+inline vector3x8 max(const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { max(l.x, r.x), max(l.y, r.y), max(l.z, r.z) };
+}
+
+/**
+ * @brief Picks the vectors of `l` in lanes where the mask is set, and of `r` elsewhere.
+ */
+inline vector3x8 select(const float8& mask, const vector3x8& l, const vector3x8& r)
+{
+    return vector3x8 { select(mask, l.x, r.x), select(mask, l.y, r.y), select(mask, l.z, r.z) };
+}
+
+/**
+ * @brief Transforms eight points by the same affine matrix, like \ref transform_point.
+ */
+inline vector3x8 transform_point(const matrix4f& m, const vector3x8& p)
+{
+    return vector3x8 {
+        float8::broadcast(m[0].x) * p.x + float8::broadcast(m[1].x) * p.y + float8::broadcast(m[2].x) * p.z +
+            float8::broadcast(m[3].x),
+        float8::broadcast(m[0].y) * p.x + float8::broadcast(m[1].y) * p.y + float8::broadcast(m[2].y) * p.z +
+            float8::broadcast(m[3].y),
+        float8::broadcast(m[0].z) * p.x + float8::broadcast(m[1].z) * p.y + float8::broadcast(m[2].z) * p.z +
+            float8::broadcast(m[3].z)
+    };
+}
+
+/**
+ * @brief Transforms eight directions by the same matrix, like \ref transform_direction.
+ */
+inline vector3x8 transform_direction(const matrix4f& m, const vector3x8& d)
+{
+    return vector3x8 {
+        float8::broadcast(m[0].x) * d.x + float8::broadcast(m[1].x) * d.y + float8::broadcast(m[2].x) * d.z,
+        float8::broadcast(m[0].y) * d.x + float8::broadcast(m[1].y) * d.y + float8::broadcast(m[2].y) * d.z,
+        float8::broadcast(m[0].z) * d.x + float8::broadcast(m[1].z) * d.y + float8::broadcast(m[2].z) * d.z
+    };
+}
@@ -1,27 +1,275 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
 #include "math/arithmetic.hpp"
+#include "math/simd.hpp"
+#include "math/vector3.hpp"
+
+/**
+ * @brief Float vectors are aligned to 16 bytes, so they load into a single SSE register.
+ */
+template<arithmetic A>
+struct alignas(std::is_same_v<A, float> ? 16 : alignof(A)) vector4
+{
+    union { A x = 0, r; };
+    union { A y = 0, g; };
+	union { A z = 0, b; };
+	union { A w = 0, a; };
+
+    constexpr A& operator [] (size_t i) { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+    constexpr const A& operator [] (size_t i) const { return i == 0 ? x : i == 1 ? y : i == 2 ? z : w; }
+
+    /**
+     * @brief Returns the first three components.
+     */
+    constexpr vector3<A> xyz() const { return vector3<A> { x, y, z }; }
+
+    // Defined by the binary operators, so float vectors use SSE.
+    constexpr vector4& operator += (const vector4& o) { return *this = *this + o; }
+    constexpr vector4& operator -= (const vector4& o) { return *this = *this - o; }
+    constexpr vector4& operator *= (A o) { return *this = *this * o; }
+    constexpr vector4& operator /= (A o) { return *this = *this / o; }
+};
 
-// Pre-define friend-template functions so the compiler knows they're templated.
-template <arithmetic A> struct vector4;
-template <arithmetic A> bool operator == (const vector4<A>& l, const vector4<A>& r)
+template <arithmetic A>
+constexpr bool operator == (const vector4<A>& l, const vector4<A>& r)
 {
     return l.x == r.x && l.y == r.y && l.z == r.z && l.w == r.w;
 }
 
 template<arithmetic A>
-struct vector4
+constexpr vector4<A> operator - (const vector4<A>& v)
 {
-    union { A x, r; };
-    union { A y, g; };
-	union { A z, b; };
-	union { A w, a; };
+    return vector4<A> {
+        -v.x,
+        -v.y,
+        -v.z,
+        -v.w
+    };
+}
 
-    friend bool operator ==<> (const vector4<A>& l, const vector4<A>& r);
-};
+template<arithmetic A>
+constexpr vector4<A> operator + (const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        l.x + r.x,
+        l.y + r.y,
+        l.z + r.z,
+        l.w + r.w
+    };
+}
 
-struct vector4i : public vector4<int> {};
+template<arithmetic A>
+constexpr vector4<A> operator - (const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        l.x - r.x,
+        l.y - r.y,
+        l.z - r.z,
+        l.w - r.w
+    };
+}
 
-struct vector4f : public vector4<float> {};
+/**
+ * @brief Multiplies component-wise.
+ */
+template<arithmetic A>
+constexpr vector4<A> operator * (const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        l.x * r.x,
+        l.y * r.y,
+        l.z * r.z,
+        l.w * r.w
+    };
+}
+
+template<arithmetic A>
+constexpr vector4<A> operator * (A l, const vector4<A>& r)
+{
+    return vector4<A> {
+        l * r.x,
+        l * r.y,
+        l * r.z,
+        l * r.w
+    };
+}
+
+template<arithmetic A>
+constexpr vector4<A> operator * (const vector4<A>& l, A r)
+{
+    return r * l;
+}
+
+/**
+ * @brief Divides component-wise.
+ */
+template<arithmetic A>
+constexpr vector4<A> operator / (const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        l.x / r.x,
+        l.y / r.y,
+        l.z / r.z,
+        l.w / r.w
+    };
+}
+
+template<arithmetic A>
+constexpr vector4<A> operator / (const vector4<A>& l, A r)
+{
+    return vector4<A> {
+        l.x / r,
+        l.y / r,
+        l.z / r,
+        l.w / r
+    };
+}
+
+template<arithmetic A>
+constexpr A dot(const vector4<A>& l, const vector4<A>& r)
+{
+    return l.x * r.x + l.y * r.y + l.z * r.z + l.w * r.w;
+}
+
+template<arithmetic A>
+constexpr A length_squared(const vector4<A>& v)
+{
+    return dot(v, v);
+}
+
+template<std::floating_point A>
+A length(const vector4<A>& v)
+{
+    return std::sqrt(length_squared(v));
+}
+
+/**
+ * @brief Returns the vector scaled to a length of 1. The vector must not be zero.
+ */
+template<std::floating_point A>
+vector4<A> normalize(const vector4<A>& v)
+{
+    return v / length(v);
+}
+
+template<arithmetic A>
+constexpr vector4<A> min(const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        std::min(l.x, r.x),
+        std::min(l.y, r.y),
+        std::min(l.z, r.z),
+        std::min(l.w, r.w)
+    };
+}
 
-struct vector4d : public vector4<double> {};
+template<arithmetic A>
+constexpr vector4<A> max(const vector4<A>& l, const vector4<A>& r)
+{
+    return vector4<A> {
+        std::max(l.x, r.x),
+        std::max(l.y, r.y),
+        std::max(l.z, r.z),
+        std::max(l.w, r.w)
+    };
+}
+
+typedef vector4<int> vector4i;
+typedef vector4<float> vector4f;
+typedef vector4<double> vector4d;
+
+#ifdef I_SIMD_SSE
+// SSE versions of the float operations. Overload resolution prefers them over the templates, which they fall back to
+// during constant evaluation.
+
+inline __m128 vector4_load(const vector4f& v)
+{
+    return _mm_load_ps(&v.x);
+}
+
+inline vector4f vector4_store(__m128 v)
+{
+    vector4f out;
+    _mm_store_ps(&out.x, v);
+
+    return out;
+}
+
+constexpr vector4f operator + (const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator +<float>(l, r);
+
+    return vector4_store(_mm_add_ps(vector4_load(l), vector4_load(r)));
+}
+
+constexpr vector4f operator - (const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator -<float>(l, r);
+
+    return vector4_store(_mm_sub_ps(vector4_load(l), vector4_load(r)));
+}
+
+constexpr vector4f operator * (const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator *<float>(l, r);
+
+    return vector4_store(_mm_mul_ps(vector4_load(l), vector4_load(r)));
+}
+
+constexpr vector4f operator * (float l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator *<float>(l, r);
+
+    return vector4_store(_mm_mul_ps(_mm_set1_ps(l), vector4_load(r)));
+}
+
+constexpr vector4f operator * (const vector4f& l, float r)
+{
+    return r * l;
+}
+
+constexpr vector4f operator / (const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return operator /<float>(l, r);
+
+    return vector4_store(_mm_div_ps(vector4_load(l), vector4_load(r)));
+}
+
+constexpr vector4f operator / (const vector4f& l, float r)
+{
+    if (std::is_constant_evaluated()) return operator /<float>(l, r);
+
+    return vector4_store(_mm_div_ps(vector4_load(l), _mm_set1_ps(r)));
+}
+
+constexpr float dot(const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return dot<float>(l, r);
+
+    // Add the products pairwise, as SSE2 has no horizontal add.
+    __m128 products = _mm_mul_ps(vector4_load(l), vector4_load(r));
+    __m128 swapped = _mm_shuffle_ps(products, products, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(products, swapped);
+
+    return _mm_cvtss_f32(_mm_add_ss(sums, _mm_movehl_ps(swapped, sums)));
+}
+
+constexpr vector4f min(const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return min<float>(l, r);
+
+    return vector4_store(_mm_min_ps(vector4_load(l), vector4_load(r)));
+}
+
+constexpr vector4f max(const vector4f& l, const vector4f& r)
+{
+    if (std::is_constant_evaluated()) return max<float>(l, r);
+
+    return vector4_store(_mm_max_ps(vector4_load(l), vector4_load(r)));
+}
+#endif
@@ -1,17 +1,140 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
-bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t width, int32_t height);
+/**
+ * @brief A read-only view of a file mapped into memory.
+ */
+struct PlatformFileMapping
+{
+	const uint8_t* data;
+	uint64_t size;
+};
+
+/**
+ * @brief The implementations of the windowing functions of the platform.
+ */
+enum class PlatformBackend
+{
+	// A window with input, which renderer surfaces can be created for.
+	WINDOWED,
+
+	// No window, input or surface, for dedicated servers and benchmarks on machines without a display. Interrupting or
+	// terminating the process fires \ref ON_WINDOW_CLOSE instead of closing a window.
+	HEADLESS
+};
+
+/**
+ * @brief Called by \ref platform_wait_for_messages when a watched descriptor becomes readable.
+ */
+typedef void (*platform_ready_cb)(int64_t descriptor, void* user_data);
+
+/**
+ * @brief Initializes the platform with a backend. Timing, sleeping, memory and file mapping work with every backend.
+ *
+ * The window arguments are ignored by the headless backend.
+ */
+bool platform_init(
+	PlatformBackend backend,
+	std::string application_name,
+	int32_t x,
+	int32_t y,
+	int32_t width,
+	int32_t height
+);
 
 void platform_shutdown();
 
+PlatformBackend platform_get_backend();
+
 bool platform_poll_messages();
 
-double platform_get_absolute_time();
+/**
+ * @brief Returns the time in nanoseconds on a monotonic clock with an arbitrary epoch.
+ *
+ * Only differences between two times are meaningful. Stays exact for centuries of uptime.
+ */
+uint64_t platform_get_time_ns();
 
 void platform_sleep(uint64_t ms);
 
+/**
+ * @brief Blocks until a time returned by \ref platform_get_time_ns, typically within a few microseconds.
+ *
+ * Sleeps through most of the wait and spins for the rest, as the OS may wake sleeping threads late. How early the sleep
+ * ends adapts to how late the calling thread was woken recently, so the spin stays short.
+ */
+void platform_sleep_until(uint64_t deadline_ns);
+
+/**
+ * @brief Blocks until the window has messages to poll, \ref platform_wake is called, a watched descriptor becomes
+ * readable, or a deadline passes. Only call from the thread that polls messages.
+ *
+ * Uses no CPU while waiting. The deadline is kept as precisely as by \ref platform_sleep_until. Callbacks of watched
+ * descriptors that became readable are invoked before returning.
+ *
+ * @param deadline_ns A time returned by \ref platform_get_time_ns.
+ * @return true if woken before the deadline, false once the deadline has passed.
+ */
+bool platform_wait_for_messages(uint64_t deadline_ns);
+
+/**
+ * @brief Makes the current or next \ref platform_wait_for_messages return early. Thread safe, and safe to call from
+ * signal handlers.
+ */
+void platform_wake();
+
+/**
+ * @brief Wakes \ref platform_wait_for_messages whenever a descriptor becomes readable, e.g. a network socket.
+ *
+ * The callback runs on the thread that waits, and should read from the descriptor, as it is invoked again for as
+ * long as the descriptor stays readable.
+ *
+ * @param descriptor A file descriptor on POSIX systems.
+ * @return false if the descriptor is already watched or can't be watched.
+ */
+bool platform_watch_descriptor(int64_t descriptor, platform_ready_cb callback, void* user_data);
+
+void platform_unwatch_descriptor(int64_t descriptor);
+
 std::vector<const char*> platform_get_required_instance_extensions();
+
+/**
+ * @brief Maps a whole file into memory for reading. Pages are loaded on first access.
+ *
+ * Writes made to the file after mapping it may or may not become visible through the mapping.
+ */
+std::optional<PlatformFileMapping> platform_map_file(const std::string& path);
+
+void platform_unmap_file(const PlatformFileMapping& mapping);
+
+uint64_t platform_get_page_size();
+
+/**
+ * @brief Reserves a range of address space without backing it with memory.
+ *
+ * @param size The size of the range in bytes. Rounded up to the page size.
+ *
+ * @return nullptr if the range could not be reserved.
+ */
+void* platform_reserve_memory(uint64_t size);
+
+/**
+ * @brief Backs pages of a reserved range with zeroed, readable and writable memory.
+ *
+ * @param address Page aligned address within a reserved range.
+ */
+bool platform_commit_memory(void* address, uint64_t size);
+
+/**
+ * @brief Returns the memory backing pages of a reserved range to the system. The pages stay reserved.
+ */
+void platform_decommit_memory(void* address, uint64_t size);
+
+/**
+ * @brief Releases a whole range returned by \ref platform_reserve_memory.
+ */
+void platform_release_memory(void* address, uint64_t size);
@@ -0,0 +1,56 @@
+#include "platform/platform_headless.hpp"
+
+#include <csignal>
+
+#include <simple-logger.hpp>
+
+#include "event.hpp"
+#include "platform/platform.hpp"
+
+// Set by the signal handler. Only lock-free atomics and `volatile std::sig_atomic_t` may be written from one.
+static volatile std::sig_atomic_t quit_requested = 0;
+
+static void on_quit_signal(int);
+
+bool platform_headless_init()
+{
+	quit_requested = 0;
+
+	// There is no window to close, so interrupting or terminating the process asks it to quit instead.
+	if (std::signal(SIGINT, on_quit_signal) == SIG_ERR || std::signal(SIGTERM, on_quit_signal) == SIG_ERR)
+	{
+		sl::log_fatal("Failed to install the quit signal handlers.");
+		return false;
+	}
+
+	sl::log_info("Successfully initialized the headless platform subsystem.");
+
+	return true;
+}
+
+void platform_headless_shutdown()
+{
+	std::signal(SIGINT, SIG_DFL);
+	std::signal(SIGTERM, SIG_DFL);
+
+	sl::log_info("Successfully shut down the headless platform subsystem.");
+}
+
+bool platform_headless_poll_messages()
+{
+	if (quit_requested)
+	{
+		quit_requested = 0;
+
+		event_fire(EventCodes::ON_WINDOW_CLOSE, EventContext {});
+	}
+
+	return true;
+}
+
+static void on_quit_signal(int)
+{
+	quit_requested = 1;
+
+	platform_wake();
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+ * The headless backend, shared by every OS. The OS specific platform functions forward to these when the headless
+ * backend is selected.
+ */
+
+bool platform_headless_init();
+
+void platform_headless_shutdown();
+
+bool platform_headless_poll_messages();
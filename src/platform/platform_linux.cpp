@@ -3,11 +3,20 @@
 #ifdef I_ISLINUX
 
 #include <xcb/xcb.h>
+#include <xcb/xinput.h>  // sudo apt-get install libxcb-xinput-dev
 #include <X11/keysym.h>
 #include <X11/XKBlib.h>  // sudo apt-get install libx11-dev
 #include <X11/Xlib.h>
 #include <X11/Xlib-xcb.h>  // sudo apt-get install libxkbcommon-x11-dev
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 //#define _POSIX_C_SOURCE 199309L
 #if _POSIX_C_SOURCE >= 199309L
@@ -16,14 +25,21 @@
 #include <unistd.h>  // usleep
 #endif
 
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #include <simple-logger.hpp>
 
 #include "event.hpp"
 #include "input.hpp"
+#include "platform/platform_headless.hpp"
 
 #include "renderer/renderer_platform.hpp"
 
@@ -31,8 +47,16 @@
 
 Keys translate_keycode(uint32_t x_keycode);
 
+struct PlatformWatch
+{
+	platform_ready_cb callback;
+	void* user_data;
+};
+
 typedef struct internal_state
 {
+	PlatformBackend backend;
+
 	Display* display;
 	xcb_connection_t* connection;
 	xcb_window_t window;
@@ -40,15 +64,72 @@ typedef struct internal_state
 
 	xcb_atom_t wm_protocols;
 	xcb_atom_t wm_delete_win;
+
+	// The major opcode of XInput 2, which tags its generic events. 0 when the server doesn't support it.
+	uint8_t xinput_opcode;
+
+	// Raw motion is reported for the whole screen, so it is dropped while another window has focus.
+	bool has_focus;
+
+	// An event XCB read while checking for queued events, handed to the next poll.
+	xcb_generic_event_t* pending_event;
+
+	// The reactor. Waits on the X connection, the wakeup eventfd, the deadline timerfd and watched descriptors at once.
+	int epoll_fd = -1;
+	int wake_fd = -1;
+	int timer_fd = -1;
+
+	std::unordered_map<int, PlatformWatch> watches;
 } internal_state;
 
 static internal_state state;
 
-bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t width, int32_t height)
+static bool reactor_init();
+static void reactor_shutdown();
+static bool reactor_add(int fd);
+
+static bool xinput_init();
+static void xinput_process_raw_motion(const xcb_input_raw_motion_event_t* event);
+
+static xcb_generic_event_t* next_event();
+
+// How late sleeps of this thread woke up recently, decaying slowly so a single late wakeup isn't forgotten at once.
+static thread_local uint64_t wakeup_latency = 100'000;
+
+static uint64_t get_sleep_margin();
+static void record_wakeup_latency(uint64_t target, uint64_t now);
+static void spin_until(uint64_t deadline_ns, uint64_t now);
+
+bool platform_init(
+	PlatformBackend backend,
+	std::string application_name,
+	int32_t x,
+	int32_t y,
+	int32_t width,
+	int32_t height
+)
 {
+	state.backend = backend;
+
+	if (!reactor_init())
+	{
+		return false;
+	}
+
+	if (backend == PlatformBackend::HEADLESS)
+	{
+		return platform_headless_init();
+	}
+
 	// Connect to X
 	state.display = XOpenDisplay(NULL);
 
+	if (!state.display)
+	{
+		sl::log_fatal("Failed to open the X display. Use the headless backend on machines without a display.");
+		return false;
+	}
+
 	// Turn off key repeats
 	XAutoRepeatOff(state.display);
 
@@ -86,7 +167,7 @@ bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t w
 	uint32_t event_values = XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
 					   XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
 					   XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_POINTER_MOTION |
-					   XCB_EVENT_MASK_STRUCTURE_NOTIFY;
+					   XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_FOCUS_CHANGE;
 
 	// Values to be sent over XCB (bg colour, events)
 	uint32_t value_list[] = {state.screen->black_pixel, event_values};
@@ -151,6 +232,12 @@ bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t w
 		1,
 		&wm_delete_reply->atom);
 
+	// Raw mouse motion is optional, the window works without it.
+	if (!xinput_init())
+	{
+		sl::log_warn("XInput 2 is unavailable, raw mouse motion won't be reported.");
+	}
+
 	// Map the window to the screen
 	xcb_map_window(state.connection, state.window);
 
@@ -161,31 +248,53 @@ bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t w
 		return false;
 	}
 
+	// Wake the reactor whenever the X server sends something.
+	if (!reactor_add(xcb_get_file_descriptor(state.connection)))
+	{
+		sl::log_fatal("Failed to watch the X connection.");
+		return false;
+	}
+
 	return true;
 }
 
 void platform_shutdown()
 {
-	XAutoRepeatOn(state.display);
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		platform_headless_shutdown();
+	}
+	else
+	{
+		free(state.pending_event);
+		state.pending_event = nullptr;
 
-	xcb_destroy_window(state.connection, state.window);
+		XAutoRepeatOn(state.display);
+
+		xcb_destroy_window(state.connection, state.window);
+	}
+
+	reactor_shutdown();
+}
+
+PlatformBackend platform_get_backend()
+{
+	return state.backend;
 }
 
 bool platform_poll_messages()
 {
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		return platform_headless_poll_messages();
+	}
+
 	xcb_generic_event_t* event;
 	xcb_client_message_event_t* cm;
 
 	// Poll for events until null is returned.
-	while (event != 0)
+	while ((event = next_event()) != nullptr)
 	{
-		event = xcb_poll_for_event(state.connection);
-
-		if (event == 0)
-		{
-			break;
-		}
-
 		// Input events
 		switch (event->response_type & ~0x80)
 		{
@@ -247,6 +356,21 @@ bool platform_poll_messages()
 				// Pass over to the input subsystem.
 				input_process_mouse_move(vector2i { move_event->event_x, move_event->event_y });
 			} break;
+			case XCB_FOCUS_IN:
+			case XCB_FOCUS_OUT:
+			{
+				state.has_focus = (event->response_type & ~0x80) == XCB_FOCUS_IN;
+			} break;
+			case XCB_GE_GENERIC:
+			{
+				xcb_ge_generic_event_t* generic_event = (xcb_ge_generic_event_t*)event;
+
+				if (state.xinput_opcode != 0 && generic_event->extension == state.xinput_opcode &&
+					generic_event->event_type == XCB_INPUT_RAW_MOTION && state.has_focus)
+				{
+					xinput_process_raw_motion((xcb_input_raw_motion_event_t*)event);
+				}
+			} break;
 			case XCB_CONFIGURE_NOTIFY:
 			{
 				// Window resize. Also triggered by moving the window;
@@ -279,11 +403,11 @@ bool platform_poll_messages()
 	return true;
 }
 
-double platform_get_absolute_time()
+uint64_t platform_get_time_ns()
 {
 	struct timespec now;
 	clock_gettime(CLOCK_MONOTONIC, &now);
-	return now.tv_sec + now.tv_nsec * 0.000000001;
+	return static_cast<uint64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
 }
 
 void platform_sleep(uint64_t ms)
@@ -303,6 +427,409 @@ void platform_sleep(uint64_t ms)
 #endif
 }
 
+void platform_sleep_until(uint64_t deadline_ns)
+{
+	uint64_t now = platform_get_time_ns();
+
+	// Sleep until shortly before the deadline, leaving room for the wakeup latency.
+	uint64_t sleep_margin = get_sleep_margin();
+
+	if (deadline_ns > now + sleep_margin)
+	{
+		uint64_t sleep_target = deadline_ns - sleep_margin;
+
+		struct timespec ts;
+		ts.tv_sec = sleep_target / 1'000'000'000;
+		ts.tv_nsec = sleep_target % 1'000'000'000;
+
+		// Sleeping until an absolute time makes interrupted sleeps resume without drifting.
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+
+		now = platform_get_time_ns();
+
+		record_wakeup_latency(sleep_target, now);
+	}
+
+	spin_until(deadline_ns, now);
+}
+
+bool platform_wait_for_messages(uint64_t deadline_ns)
+{
+	if (state.backend == PlatformBackend::WINDOWED)
+	{
+		// Requests may still be buffered, and replies to earlier requests may have brought events along that were
+		// already read from the connection, so its descriptor would never become readable for them.
+		xcb_flush(state.connection);
+
+		if (!state.pending_event)
+		{
+			state.pending_event = xcb_poll_for_queued_event(state.connection);
+		}
+
+		if (state.pending_event)
+		{
+			return true;
+		}
+	}
+
+	uint64_t now = platform_get_time_ns();
+	uint64_t sleep_margin = get_sleep_margin();
+
+	if (deadline_ns > now + sleep_margin)
+	{
+		uint64_t wake_target = deadline_ns - sleep_margin;
+
+		// Rearming the timer also resets expirations from earlier waits that weren't read.
+		struct itimerspec timer_spec = {};
+		timer_spec.it_value.tv_sec = wake_target / 1'000'000'000;
+		timer_spec.it_value.tv_nsec = wake_target % 1'000'000'000;
+
+		timerfd_settime(state.timer_fd, TFD_TIMER_ABSTIME, &timer_spec, nullptr);
+
+		struct epoll_event events[16];
+		int event_count = epoll_wait(state.epoll_fd, events, 16, -1);
+
+		now = platform_get_time_ns();
+
+		if (event_count == -1)
+		{
+			// Interrupted by a signal, whose handler may have requested something of the loop.
+			if (errno != EINTR)
+			{
+				sl::log_error("Failed to wait for platform messages.");
+			}
+
+			return true;
+		}
+
+		bool woken = false;
+
+		for (int i = 0; i < event_count; i++)
+		{
+			int fd = events[i].data.fd;
+			uint64_t value;
+
+			if (fd == state.timer_fd)
+			{
+				read(state.timer_fd, &value, sizeof(value));
+
+				record_wakeup_latency(wake_target, now);
+			}
+			else if (fd == state.wake_fd)
+			{
+				read(state.wake_fd, &value, sizeof(value));
+
+				woken = true;
+			}
+			else if (auto it = state.watches.find(fd); it != state.watches.end())
+			{
+				it->second.callback(fd, it->second.user_data);
+
+				woken = true;
+			}
+			else
+			{
+				// The X connection.
+				woken = true;
+			}
+		}
+
+		if (woken)
+		{
+			return true;
+		}
+	}
+
+	spin_until(deadline_ns, now);
+
+	return false;
+}
+
+void platform_wake()
+{
+	if (state.wake_fd != -1)
+	{
+		uint64_t value = 1;
+
+		write(state.wake_fd, &value, sizeof(value));
+	}
+}
+
+bool platform_watch_descriptor(int64_t descriptor, platform_ready_cb callback, void* user_data)
+{
+	int fd = static_cast<int>(descriptor);
+
+	if (state.watches.contains(fd))
+	{
+		sl::log_error("Descriptor {} is already watched.", fd);
+		return false;
+	}
+
+	if (!reactor_add(fd))
+	{
+		sl::log_error("Failed to watch descriptor {}.", fd);
+		return false;
+	}
+
+	state.watches[fd] = PlatformWatch { callback, user_data };
+
+	return true;
+}
+
+void platform_unwatch_descriptor(int64_t descriptor)
+{
+	int fd = static_cast<int>(descriptor);
+
+	if (state.watches.erase(fd))
+	{
+		epoll_ctl(state.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	}
+}
+
+static bool reactor_init()
+{
+	state.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	state.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	state.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+
+	if (state.epoll_fd == -1 || state.wake_fd == -1 || state.timer_fd == -1 ||
+		!reactor_add(state.wake_fd) || !reactor_add(state.timer_fd))
+	{
+		sl::log_fatal("Failed to create the platform reactor.");
+
+		reactor_shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+static void reactor_shutdown()
+{
+	state.watches.clear();
+
+	for (int* fd : { &state.timer_fd, &state.wake_fd, &state.epoll_fd })
+	{
+		if (*fd != -1)
+		{
+			close(*fd);
+			*fd = -1;
+		}
+	}
+}
+
+static bool reactor_add(int fd)
+{
+	struct epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+
+	return epoll_ctl(state.epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+static bool xinput_init()
+{
+	const xcb_query_extension_reply_t* extension = xcb_get_extension_data(state.connection, &xcb_input_id);
+
+	if (!extension || !extension->present)
+	{
+		return false;
+	}
+
+	// The server replies with the highest version both sides support. Raw events exist since 2.0.
+	xcb_input_xi_query_version_reply_t* version = xcb_input_xi_query_version_reply(
+		state.connection,
+		xcb_input_xi_query_version(state.connection, 2, 2),
+		nullptr);
+
+	if (!version)
+	{
+		return false;
+	}
+
+	bool supported = version->major_version >= 2;
+
+	free(version);
+
+	if (!supported)
+	{
+		return false;
+	}
+
+	// Raw events are only delivered to the root window.
+	struct
+	{
+		xcb_input_event_mask_t header;
+		uint32_t mask;
+	} mask = {};
+
+	mask.header.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+	mask.header.mask_len = 1;
+	mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_MOTION;
+
+	xcb_input_xi_select_events(state.connection, state.screen->root, 1, &mask.header);
+
+	state.xinput_opcode = extension->major_opcode;
+
+	return true;
+}
+
+static void xinput_process_raw_motion(const xcb_input_raw_motion_event_t* event)
+{
+	// XInput only timestamps in milliseconds, too coarse for high rate mice, so the time of receipt is used instead.
+	uint64_t time = platform_get_time_ns();
+
+	const uint32_t* valuator_mask = xcb_input_raw_button_press_valuator_mask(event);
+	const xcb_input_fp3232_t* values = xcb_input_raw_button_press_axisvalues_raw(event);
+
+	// Values are only sent for the valuators set in the mask, in order. Valuators 0 and 1 are the x and y axes.
+	double axes[2] = {};
+	int value_index = 0;
+
+	for (uint32_t valuator = 0; valuator < 2 && valuator < event->valuators_len * 32u; valuator++)
+	{
+		if (valuator_mask[valuator / 32] & (1u << (valuator % 32)))
+		{
+			const xcb_input_fp3232_t& value = values[value_index++];
+
+			axes[valuator] = value.integral + value.frac / 4294967296.0;
+		}
+	}
+
+	if (axes[0] != 0.0 || axes[1] != 0.0)
+	{
+		input_process_raw_mouse_motion(time, vector2f { (float)axes[0], (float)axes[1] });
+	}
+}
+
+static xcb_generic_event_t* next_event()
+{
+	if (state.pending_event)
+	{
+		xcb_generic_event_t* event = state.pending_event;
+		state.pending_event = nullptr;
+
+		return event;
+	}
+
+	return xcb_poll_for_event(state.connection);
+}
+
+static uint64_t get_sleep_margin()
+{
+	return std::clamp<uint64_t>(wakeup_latency + wakeup_latency / 2, 50'000, 4'000'000);
+}
+
+static void record_wakeup_latency(uint64_t target, uint64_t now)
+{
+	uint64_t latency = now > target ? now - target : 0;
+
+	if (latency > wakeup_latency)
+	{
+		wakeup_latency = latency;
+	}
+	else
+	{
+		wakeup_latency -= (wakeup_latency - latency) / 16;
+	}
+}
+
+static void spin_until(uint64_t deadline_ns, uint64_t now)
+{
+	while (now < deadline_ns)
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#elif defined(__aarch64__)
+		asm volatile("yield");
+#endif
+
+		now = platform_get_time_ns();
+	}
+}
+
+std::optional<PlatformFileMapping> platform_map_file(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd == -1)
+	{
+		sl::log_error("Failed to open file `{}` for mapping.", path);
+		return std::nullopt;
+	}
+
+	struct stat file_stat;
+
+	if (fstat(fd, &file_stat) == -1 || file_stat.st_size == 0)
+	{
+		close(fd);
+
+		sl::log_error("Failed to map file `{}`: the file is empty or cannot be inspected.", path);
+		return std::nullopt;
+	}
+
+	void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+	// The mapping keeps its own reference to the file.
+	close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		sl::log_error("Failed to map file `{}`.", path);
+		return std::nullopt;
+	}
+
+	return PlatformFileMapping { static_cast<const uint8_t*>(data), static_cast<uint64_t>(file_stat.st_size) };
+}
+
+void platform_unmap_file(const PlatformFileMapping& mapping)
+{
+	munmap(const_cast<uint8_t*>(mapping.data), mapping.size);
+}
+
+uint64_t platform_get_page_size()
+{
+	static uint64_t page_size = sysconf(_SC_PAGESIZE);
+
+	return page_size;
+}
+
+void* platform_reserve_memory(uint64_t size)
+{
+	void* address = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+	if (address == MAP_FAILED)
+	{
+		sl::log_error("Failed to reserve {} bytes of address space.", size);
+		return nullptr;
+	}
+
+	return address;
+}
+
+bool platform_commit_memory(void* address, uint64_t size)
+{
+	if (mprotect(address, size, PROT_READ | PROT_WRITE) != 0)
+	{
+		sl::log_error("Failed to commit {} bytes of memory.", size);
+		return false;
+	}
+
+	return true;
+}
+
+void platform_decommit_memory(void* address, uint64_t size)
+{
+	// Drop the pages first, so they read back as zero once committed again.
+	madvise(address, size, MADV_DONTNEED);
+	mprotect(address, size, PROT_NONE);
+}
+
+void platform_release_memory(void* address, uint64_t size)
+{
+	munmap(address, size);
+}
+
 std::vector<const char*> platform_get_required_instance_extensions()
 {
 	static std::vector<const char*> required_instance_extensions = {
@@ -314,6 +841,12 @@ std::vector<const char*> platform_get_required_instance_extensions()
 
 std::optional<vk::SurfaceKHR> renderer_platform_create_vulkan_surface(vk::Instance instance)
 {
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		sl::log_fatal("The headless platform has no window to create a Vulkan surface for.");
+		return {};
+	}
+
 	VkXcbSurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR};
 	create_info.connection = state.connection;
 	create_info.window = state.window;
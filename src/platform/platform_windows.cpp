@@ -2,10 +2,13 @@
 
 #ifdef I_ISWIN
 
+#include <algorithm>
+
 #include <simple-logger.hpp>
 
 #include "event.hpp"
 #include "input.hpp"
+#include "platform/platform_headless.hpp"
 
 #include <windows.h>
 #include <windowsx.h>
@@ -17,20 +20,50 @@ static const char* window_class_name = "window_class";
 
 typedef struct internal_state
 {
+	PlatformBackend backend;
+
 	HINSTANCE h_instance;
 	HWND hwnd;
+
+	// Signaled by platform_wake.
+	HANDLE wake_event;
 } internal_state;
 
 static internal_state state;
 
-// Clock
-static double clock_frequency;
-static LARGE_INTEGER start_time;
+// How late sleeps of this thread woke up recently, decaying slowly so a single late wakeup isn't forgotten at once.
+static thread_local uint64_t wakeup_latency = 1'000'000;
+
+static HANDLE get_wait_timer();
+static uint64_t get_sleep_margin();
+static void record_wakeup_latency(uint64_t target, uint64_t now);
 
 static LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param, LPARAM l_param);
 
-bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t width, int32_t height)
+bool platform_init(
+	PlatformBackend backend,
+	std::string application_name,
+	int32_t x,
+	int32_t y,
+	int32_t width,
+	int32_t height
+)
 {
+	state.backend = backend;
+
+	state.wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+
+	if (!state.wake_event)
+	{
+		sl::log_fatal("Failed to create the platform wake event.");
+		return false;
+	}
+
+	if (backend == PlatformBackend::HEADLESS)
+	{
+		return platform_headless_init();
+	}
+
 	state.h_instance = GetModuleHandleA(0);
 
 	HICON icon = LoadIcon(state.h_instance, IDI_APPLICATION);
@@ -97,11 +130,16 @@ bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t w
 
 	ShowWindow(state.hwnd, show_window_command_flags);
 
-	// Time setup
-	LARGE_INTEGER freq;
-	QueryPerformanceFrequency(&freq);
-	clock_frequency = 1.0 / (double) freq.QuadPart;
-	QueryPerformanceCounter(&start_time);
+	// Raw mouse motion, sent as WM_INPUT while the window is in the foreground.
+	RAWINPUTDEVICE mouse_device = {};
+	mouse_device.usUsagePage = 0x01; // Generic desktop controls
+	mouse_device.usUsage = 0x02; // Mouse
+	mouse_device.hwndTarget = state.hwnd;
+
+	if (!RegisterRawInputDevices(&mouse_device, 1, sizeof(mouse_device)))
+	{
+		sl::log_warn("Failed to register for raw mouse input, raw mouse motion won't be reported.");
+	}
 
 	sl::log_info("Successfully initialized the windows platform subsystem.");
 
@@ -110,17 +148,34 @@ bool platform_init(std::string application_name, int32_t x, int32_t y, int32_t w
 
 void platform_shutdown()
 {
-	if (state.hwnd)
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		platform_headless_shutdown();
+	}
+	else if (state.hwnd)
 	{
 		DestroyWindow(state.hwnd);
 		state.hwnd = 0;
 	}
 
+	CloseHandle(state.wake_event);
+	state.wake_event = nullptr;
+
 	sl::log_info("Successfully shut down the windows platform subsystem.");
 }
 
+PlatformBackend platform_get_backend()
+{
+	return state.backend;
+}
+
 bool platform_poll_messages()
 {
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		return platform_headless_poll_messages();
+	}
+
 	MSG message;
 	while (PeekMessageA(&message, NULL, 0, 0, PM_REMOVE))
 	{
@@ -155,11 +210,23 @@ void platform_console_write_error(const char *message, uint8_t colour)
 	WriteConsoleA(GetStdHandle(STD_ERROR_HANDLE), message, (DWORD)length, number_written, 0);
 }
 
-double platform_get_absolute_time()
+uint64_t platform_get_time_ns()
 {
+	// The frequency is fixed at boot, so it is queried only once. Doesn't depend on platform_init, so the clock can be
+	// used before the platform is initialized.
+	static const uint64_t frequency = [] {
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		return static_cast<uint64_t>(freq.QuadPart);
+	}();
+
 	LARGE_INTEGER now_time;
 	QueryPerformanceCounter(&now_time);
-	return (double) now_time.QuadPart * clock_frequency;
+
+	uint64_t counter = static_cast<uint64_t>(now_time.QuadPart);
+
+	// Split the conversion, so it neither overflows nor loses precision.
+	return counter / frequency * 1'000'000'000 + counter % frequency * 1'000'000'000 / frequency;
 }
 
 void platform_sleep(uint64_t ms)
@@ -167,6 +234,137 @@ void platform_sleep(uint64_t ms)
 	Sleep(ms);
 }
 
+void platform_sleep_until(uint64_t deadline_ns)
+{
+	HANDLE timer = get_wait_timer();
+
+	uint64_t now = platform_get_time_ns();
+
+	// Sleep until shortly before the deadline, leaving room for the wakeup latency.
+	uint64_t sleep_margin = get_sleep_margin();
+
+	if (timer && deadline_ns > now + sleep_margin)
+	{
+		uint64_t sleep_target = deadline_ns - sleep_margin;
+
+		// Negative due times are relative, in 100 ns intervals.
+		LARGE_INTEGER due_time;
+		due_time.QuadPart = -static_cast<LONGLONG>((sleep_target - now) / 100);
+
+		if (SetWaitableTimer(timer, &due_time, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(timer, INFINITE);
+		}
+
+		now = platform_get_time_ns();
+
+		record_wakeup_latency(sleep_target, now);
+	}
+
+	// Spin for the rest.
+	while (now < deadline_ns)
+	{
+		YieldProcessor();
+
+		now = platform_get_time_ns();
+	}
+}
+
+bool platform_wait_for_messages(uint64_t deadline_ns)
+{
+	HANDLE timer = get_wait_timer();
+
+	uint64_t now = platform_get_time_ns();
+	uint64_t sleep_margin = get_sleep_margin();
+
+	if (timer && deadline_ns > now + sleep_margin)
+	{
+		uint64_t wake_target = deadline_ns - sleep_margin;
+
+		LARGE_INTEGER due_time;
+		due_time.QuadPart = -static_cast<LONGLONG>((wake_target - now) / 100);
+
+		SetWaitableTimer(timer, &due_time, 0, nullptr, nullptr, FALSE);
+
+		HANDLE handles[2] = { state.wake_event, timer };
+
+		// Window messages wake the wait as well, unless the platform is headless.
+		DWORD wake_mask = state.backend == PlatformBackend::WINDOWED ? QS_ALLINPUT : 0;
+		DWORD result = MsgWaitForMultipleObjects(2, handles, FALSE, INFINITE, wake_mask);
+
+		now = platform_get_time_ns();
+
+		if (result != WAIT_OBJECT_0 + 1)
+		{
+			CancelWaitableTimer(timer);
+
+			return true;
+		}
+
+		record_wakeup_latency(wake_target, now);
+	}
+
+	while (now < deadline_ns)
+	{
+		YieldProcessor();
+
+		now = platform_get_time_ns();
+	}
+
+	return false;
+}
+
+void platform_wake()
+{
+	if (state.wake_event)
+	{
+		SetEvent(state.wake_event);
+	}
+}
+
+bool platform_watch_descriptor(int64_t descriptor, platform_ready_cb callback, void* user_data)
+{
+	// Sockets would need WSAEventSelect, which pulls in Winsock. Nothing on Windows watches descriptors yet.
+	sl::log_error("Watching descriptors is not supported on Windows.");
+	return false;
+}
+
+void platform_unwatch_descriptor(int64_t descriptor)
+{
+}
+
+static HANDLE get_wait_timer()
+{
+	// High resolution timers aren't bound to the system timer resolution, which defaults to ~15.6 ms. They are only
+	// available since Windows 10 1803, so fall back to a regular timer.
+	static thread_local HANDLE timer = [] {
+		HANDLE handle = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+		return handle ? handle : CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}();
+
+	return timer;
+}
+
+static uint64_t get_sleep_margin()
+{
+	return std::clamp<uint64_t>(wakeup_latency + wakeup_latency / 2, 50'000, 20'000'000);
+}
+
+static void record_wakeup_latency(uint64_t target, uint64_t now)
+{
+	uint64_t latency = now > target ? now - target : 0;
+
+	if (latency > wakeup_latency)
+	{
+		wakeup_latency = latency;
+	}
+	else
+	{
+		wakeup_latency -= (wakeup_latency - latency) / 16;
+	}
+}
+
 static LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_param, LPARAM l_param)
 {
 	switch (msg)
@@ -215,6 +413,29 @@ static LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_
 		
 			input_process_mouse_move(vector2i { x_position, y_position });
 		} break;
+		case WM_INPUT:
+		{
+			// Timestamped on receipt, as raw input carries no time of its own.
+			uint64_t time = platform_get_time_ns();
+
+			RAWINPUT input;
+			UINT size = sizeof(input);
+
+			if (GetRawInputData((HRAWINPUT)l_param, RID_INPUT, &input, &size, sizeof(RAWINPUTHEADER)) == (UINT)-1)
+			{
+				break;
+			}
+
+			// Absolute motion comes from tablets and remote desktops, which have no raw delta.
+			if (input.header.dwType == RIM_TYPEMOUSE && !(input.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) &&
+				(input.data.mouse.lLastX != 0 || input.data.mouse.lLastY != 0))
+			{
+				input_process_raw_mouse_motion(time, vector2f {
+					(float)input.data.mouse.lLastX,
+					(float)input.data.mouse.lLastY
+				});
+			}
+		} break;
 		case WM_MOUSEWHEEL:
 		{
 			int8_t dz = GET_WHEEL_DELTA_WPARAM(w_param);
@@ -241,6 +462,103 @@ static LRESULT CALLBACK win32_process_message(HWND hwnd, uint32_t msg, WPARAM w_
 	return DefWindowProcA(hwnd, msg, w_param, l_param);
 }
 
+std::optional<PlatformFileMapping> platform_map_file(const std::string& path)
+{
+	HANDLE file = CreateFileA(
+		path.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL,
+		NULL
+	);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		sl::log_error("Failed to open file `{}` for mapping.", path);
+		return std::nullopt;
+	}
+
+	LARGE_INTEGER file_size;
+
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		CloseHandle(file);
+
+		sl::log_error("Failed to map file `{}`: the file is empty or cannot be inspected.", path);
+		return std::nullopt;
+	}
+
+	HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	void* data = file_mapping ? MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+	// The view keeps its own reference to the file.
+	if (file_mapping) CloseHandle(file_mapping);
+	CloseHandle(file);
+
+	if (!data)
+	{
+		sl::log_error("Failed to map file `{}`.", path);
+		return std::nullopt;
+	}
+
+	return PlatformFileMapping { static_cast<const uint8_t*>(data), static_cast<uint64_t>(file_size.QuadPart) };
+}
+
+void platform_unmap_file(const PlatformFileMapping& mapping)
+{
+	UnmapViewOfFile(mapping.data);
+}
+
+uint64_t platform_get_page_size()
+{
+	static uint64_t page_size = []() {
+		SYSTEM_INFO system_info;
+		GetSystemInfo(&system_info);
+
+		return static_cast<uint64_t>(system_info.dwPageSize);
+	}();
+
+	return page_size;
+}
+
+void* platform_reserve_memory(uint64_t size)
+{
+	void* address = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+
+	if (!address)
+	{
+		sl::log_error("Failed to reserve {} bytes of address space.", size);
+		return nullptr;
+	}
+
+	return address;
+}
+
+bool platform_commit_memory(void* address, uint64_t size)
+{
+	if (!VirtualAlloc(address, size, MEM_COMMIT, PAGE_READWRITE))
+	{
+		sl::log_error("Failed to commit {} bytes of memory.", size);
+		return false;
+	}
+
+	return true;
+}
+
+void platform_decommit_memory(void* address, uint64_t size)
+{
+	VirtualFree(address, size, MEM_DECOMMIT);
+}
+
+void platform_release_memory(void* address, uint64_t size)
+{
+	// The whole reservation is released at once, which requires a size of 0.
+	VirtualFree(address, 0, MEM_RELEASE);
+}
+
 std::vector<const char*> platform_get_required_instance_extensions()
 {
 	static std::vector<const char*> required_instance_extensions = {
@@ -252,6 +570,12 @@ std::vector<const char*> platform_get_required_instance_extensions()
 
 std::optional<vk::SurfaceKHR> renderer_platform_create_vulkan_surface(vk::Instance instance)
 {
+	if (state.backend == PlatformBackend::HEADLESS)
+	{
+		sl::log_fatal("The headless platform has no window to create a Vulkan surface for.");
+		return {};
+	}
+
 	VkWin32SurfaceCreateInfoKHR create_info = {VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR};
 	create_info.hinstance = state.h_instance;
 	create_info.hwnd = state.hwnd;
@@ -0,0 +1,170 @@
+#include "profiler.hpp"
+
+#include <simple-logger.hpp>
+
+constinit thread_local ProfilerThreadBuffer* profiler_thread_buffer = nullptr;
+
+#ifdef I_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+static struct
+{
+	// Read by every thread that records its first zone.
+	std::atomic<bool> initialized = false;
+
+	// Guards `threads`. Only taken when a thread records its first zone, or when exporting.
+	std::mutex mutex;
+
+	// Buffers outlive their threads, so their zones can still be exported.
+	std::vector<std::unique_ptr<ProfilerThreadBuffer>> threads;
+
+	// Pairs ticks with time, to convert ticks on export.
+	uint64_t start_ticks;
+	std::chrono::steady_clock::time_point start_time;
+} profiler_state;
+
+void profiler_init()
+{
+	profiler_state.start_ticks = profiler_get_ticks();
+	profiler_state.start_time = std::chrono::steady_clock::now();
+
+	profiler_state.initialized.store(true, std::memory_order_release);
+
+	profiler_set_thread_name("main");
+
+	sl::log_info("Successfully initialized the profiler.");
+}
+
+void profiler_shutdown()
+{
+	profiler_state.initialized.store(false, std::memory_order_release);
+
+	sl::log_info("Successfully shut down the profiler.");
+}
+
+void profiler_set_thread_name(const char* name)
+{
+	ProfilerThreadBuffer* buffer = profiler_thread_buffer ? profiler_thread_buffer : profiler_create_thread_buffer();
+
+	if (buffer)
+	{
+		buffer->thread_name = name;
+	}
+}
+
+bool profiler_export_chrome_trace(const std::string& path)
+{
+	std::ofstream file(path);
+
+	if (!file)
+	{
+		sl::log_error("Failed to open `{}` to export the profile.", path);
+		return false;
+	}
+
+	// Calibrate the ticks against the time passed since initialization.
+	uint64_t end_ticks = profiler_get_ticks();
+	auto end_time = std::chrono::steady_clock::now();
+
+	double elapsed_us = std::chrono::duration<double, std::micro>(end_time - profiler_state.start_time).count();
+	double us_per_tick = elapsed_us / static_cast<double>(std::max<uint64_t>(end_ticks - profiler_state.start_ticks, 1));
+
+	auto to_us = [us_per_tick](uint64_t ticks) {
+		return static_cast<double>(static_cast<int64_t>(ticks - profiler_state.start_ticks)) * us_per_tick;
+	};
+
+	std::lock_guard lock(profiler_state.mutex);
+
+	file << "{\"traceEvents\":[\n";
+
+	bool first = true;
+
+	for (auto& buffer : profiler_state.threads)
+	{
+		if (!first) file << ",\n";
+		first = false;
+
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread_id
+			<< ",\"args\":{\"name\":\"" << (buffer->thread_name ? buffer->thread_name : "worker") << "\"}}";
+
+		uint64_t zone_count = buffer->zone_count.load(std::memory_order_acquire);
+		uint64_t first_zone = zone_count > PROFILER_ZONE_CAPACITY ? zone_count - PROFILER_ZONE_CAPACITY : 0;
+
+		for (uint64_t i = first_zone; i < zone_count; i++)
+		{
+			const ProfilerZone& zone = buffer->zones[i & (PROFILER_ZONE_CAPACITY - 1)];
+
+			file << ",\n{\"name\":\"" << zone.name << "\",\"pid\":0,\"tid\":" << buffer->thread_id
+				<< ",\"ts\":" << to_us(zone.start_ticks);
+
+			if (zone.start_ticks == zone.end_ticks)
+			{
+				file << ",\"ph\":\"i\",\"s\":\"g\"}";
+			}
+			else
+			{
+				file << ",\"ph\":\"X\",\"dur\":" << to_us(zone.end_ticks) - to_us(zone.start_ticks) << "}";
+			}
+		}
+	}
+
+	file << "\n]}\n";
+
+	if (!file)
+	{
+		sl::log_error("Failed to write the profile to `{}`.", path);
+		return false;
+	}
+
+	sl::log_info("Exported the profile to `{}`.", path);
+
+	return true;
+}
+
+ProfilerThreadBuffer* profiler_create_thread_buffer()
+{
+	if (!profiler_state.initialized.load(std::memory_order_acquire))
+	{
+		return nullptr;
+	}
+
+	auto buffer = std::make_unique<ProfilerThreadBuffer>();
+
+	buffer->thread_name = nullptr;
+	buffer->zones = std::make_unique<ProfilerZone[]>(PROFILER_ZONE_CAPACITY);
+	buffer->zone_count.store(0, std::memory_order_relaxed);
+
+	std::lock_guard lock(profiler_state.mutex);
+
+	buffer->thread_id = profiler_state.threads.size();
+	profiler_thread_buffer = buffer.get();
+
+	profiler_state.threads.push_back(std::move(buffer));
+
+	return profiler_thread_buffer;
+}
+
+#else
+
+void profiler_init() {}
+
+void profiler_shutdown() {}
+
+void profiler_set_thread_name(const char* name) {}
+
+ProfilerThreadBuffer* profiler_create_thread_buffer() { return nullptr; }
+
+bool profiler_export_chrome_trace(const std::string& path)
+{
+	sl::log_warn("Cannot export a profile, as the profiler is compiled out. Configure with INDUSTRIA_PROFILE=ON.");
+	return false;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+/**
+ * @brief A timed zone, or an instant event if `start_ticks` equals `end_ticks`.
+ */
+struct ProfilerZone
+{
+	const char* name;
+	uint64_t start_ticks;
+	uint64_t end_ticks;
+};
+
+// The amount of zones every thread keeps. Must be a power of two.
+#define PROFILER_ZONE_CAPACITY (1 << 16)
+
+/**
+ * @brief The zones recorded by a thread.
+ */
+struct ProfilerThreadBuffer
+{
+	uint32_t thread_id;
+	const char* thread_name;
+
+	std::unique_ptr<ProfilerZone[]> zones;
+
+	// The amount of zones ever recorded. Only written by the owning thread.
+	std::atomic<uint64_t> zone_count;
+};
+
+// The buffer of the calling thread, created when it records its first zone.
+extern constinit thread_local ProfilerThreadBuffer* profiler_thread_buffer;
+
+/**
+ * @brief Initializes the profiler. Zones recorded before initialization are dropped.
+ */
+void profiler_init();
+
+void profiler_shutdown();
+
+/**
+ * @brief Names the calling thread in exported traces.
+ * 
+ * @param name Must stay valid until the profiler shuts down, e.g. a string literal.
+ */
+void profiler_set_thread_name(const char* name);
+
+/**
+ * @brief Creates the buffer of the calling thread.
+ * 
+ * @return nullptr if the profiler is not initialized.
+ */
+ProfilerThreadBuffer* profiler_create_thread_buffer();
+
+/**
+ * @brief Records a zone for the calling thread. Prefer the \ref PROFILE_SCOPE macro.
+ * 
+ * Every thread records into its own ring buffer, so the oldest zones are overwritten once it is full.
+ */
+inline void profiler_record_zone(const char* name, uint64_t start_ticks, uint64_t end_ticks)
+{
+	ProfilerThreadBuffer* buffer = profiler_thread_buffer;
+
+	if (!buffer && !(buffer = profiler_create_thread_buffer()))
+	{
+		return;
+	}
+
+	uint64_t zone_count = buffer->zone_count.load(std::memory_order_relaxed);
+
+	buffer->zones[zone_count & (PROFILER_ZONE_CAPACITY - 1)] = ProfilerZone { name, start_ticks, end_ticks };
+
+	buffer->zone_count.store(zone_count + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Exports the recorded zones in the Chrome `trace_event` JSON format, which Perfetto can open as well.
+ * 
+ * Zones that are recorded by other threads during the export may be missing or incomplete.
+ * 
+ * @return false if the profiler is compiled out or the file could not be written.
+ */
+bool profiler_export_chrome_trace(const std::string& path);
+
+/**
+ * @brief Returns a timestamp in an unspecified unit, as cheaply as possible. Converted to time when exporting.
+ */
+inline uint64_t profiler_get_ticks()
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return __rdtsc();
+#else
+	return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+/**
+ * @brief Records a zone spanning its own lifetime.
+ */
+struct ProfilerScope
+{
+	const char* name;
+	uint64_t start_ticks;
+
+	explicit ProfilerScope(const char* name) : name {name}, start_ticks {profiler_get_ticks()} {}
+
+	ProfilerScope(const ProfilerScope&) = delete; // Prevent copies.
+
+	~ProfilerScope() { profiler_record_zone(name, start_ticks, profiler_get_ticks()); }
+
+	ProfilerScope& operator = (const ProfilerScope&) = delete; // Prevent copies.
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef I_PROFILE
+
+/**
+ * @brief Records a zone from this point until the end of the enclosing scope.
+ * 
+ * A zone costs two \ref profiler_get_ticks calls plus a few ns to record, and should stay well under 50 ns. Run
+ * `profiler_zone_bench` to measure it on the target machine. Keep zones out of loops that run thousands of times per
+ * frame.
+ * 
+ * @param name A string literal.
+ */
+#define PROFILE_SCOPE(name) ProfilerScope PROFILE_CONCAT(profiler_scope_, __LINE__)(name)
+
+/**
+ * @brief Marks the start of a frame.
+ */
+#define PROFILE_FRAME() do { uint64_t profiler_ticks = profiler_get_ticks(); \
+	profiler_record_zone("frame", profiler_ticks, profiler_ticks); } while (false)
+
+#else
+
+#define PROFILE_SCOPE(name) do {} while (false)
+#define PROFILE_FRAME() do {} while (false)
+
+#endif
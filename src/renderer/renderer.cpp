@@ -1,15 +1,18 @@
 #include "renderer/renderer.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 #include <simple-logger.hpp>
 
 #include "platform/platform.hpp"
+#include "clock.hpp"
 #include "renderer/device.hpp"
 #include "renderer/fence.hpp"
 #include "renderer/renderer_platform.hpp"
 #include "renderer/swapchain.hpp"
 #include "renderer/voxel_shader.hpp"
+#include "renderer/vulkan_buffer.hpp"
 
 #ifdef NDEBUG
 	static constexpr bool enable_validation_layers = false;
@@ -36,6 +39,8 @@ static bool recreate_swapchain();
 static void transition_swapchain_image_to_trace(CommandBuffer* cb, uint32_t image_idx);
 static void transition_swapchain_image_to_present(CommandBuffer* cb, uint32_t image_idx);
 
+static void upload_voxel_materials(CommandBuffer* cb);
+
 // Render state.
 static struct
 {
@@ -49,6 +54,13 @@ static struct
 
 	VoxelShader* voxel_shader;
 
+	// Voxel materials.
+	VoxelMaterialTable* voxel_material_table;
+
+	std::unique_ptr<VulkanBuffer> voxel_material_buffer;
+
+	std::array<vk::DescriptorBufferInfo, (size_t) VoxelShaderMaterialArray::MAX_ENUM> voxel_material_ranges;
+
 	std::vector<std::unique_ptr<CommandBuffer>> graphics_command_buffers;
 
 	// Sync objects.
@@ -61,6 +73,18 @@ static struct
 	std::vector<Fence*> images_in_flight;
 
 	uint32_t current_image_index;
+
+	// GPU timings. Every frame in flight writes a timestamp before and after its commands, and reads them back once
+	// its fence signals. The pool is null if the graphics queue doesn't support timestamps.
+	vk::QueryPool timestamp_query_pool;
+
+	std::vector<bool> timestamps_written;
+
+	uint64_t timestamp_mask;
+
+	std::optional<uint64_t> last_gpu_frame_time;
+
+	uint64_t last_wait_time;
 } renderer_state;
 
 bool renderer_initialize()
@@ -236,6 +260,34 @@ bool renderer_initialize()
 		renderer_state.in_flight_fences.push_back(std::move(fence)); 
 	}
 
+	// Create the timestamp queries.
+	uint32_t timestamp_valid_bits = renderer_state.device->physical_device
+		.getQueueFamilyProperties()[renderer_state.device->queue_indices.graphics_queue_index].timestampValidBits;
+
+	if (timestamp_valid_bits != 0)
+	{
+		vk::QueryPoolCreateInfo query_pool_ci;
+		query_pool_ci.queryType = vk::QueryType::eTimestamp;
+		query_pool_ci.queryCount = 2 * renderer_state.swapchain->max_frames_in_flight;
+
+		std::tie(r, renderer_state.timestamp_query_pool) =
+			renderer_state.device->logical_device.createQueryPool(query_pool_ci);
+
+		if (r != vk::Result::eSuccess)
+		{
+			sl::log_error("Failed to create timestamp query pool.");
+			return false;
+		}
+
+		renderer_state.timestamp_mask = timestamp_valid_bits == 64 ? UINT64_MAX : (uint64_t(1) << timestamp_valid_bits) - 1;
+	}
+	else
+	{
+		sl::log_warn("The graphics queue doesn't support timestamps, GPU frame times are unavailable.");
+	}
+
+	renderer_state.timestamps_written.resize(renderer_state.swapchain->max_frames_in_flight, false);
+
 	// Preallocate the in flight images and set them to nullptr;
 	renderer_state.images_in_flight.resize(renderer_state.swapchain->images.size(), nullptr);
 
@@ -254,8 +306,12 @@ void renderer_shutdown()
 
 	renderer_state.in_flight_fences.clear();
 
+	renderer_state.device->logical_device.destroy(renderer_state.timestamp_query_pool);
+
 	renderer_state.graphics_command_buffers.clear();
 
+	renderer_state.voxel_material_buffer.reset();
+
 	delete renderer_state.voxel_shader;
 
 	delete renderer_state.swapchain;
@@ -279,6 +335,9 @@ bool renderer_begin_frame()
 
 	uint8_t current_frame = renderer_state.swapchain->current_frame;
 
+	Clock wait_clock;
+	wait_clock.reset();
+
 	// Wait for the current frame
 	if (!renderer_state.in_flight_fences[current_frame]->wait())
 	{
@@ -286,6 +345,31 @@ bool renderer_begin_frame()
 		return false;
 	}
 
+	// The frame that last used this slot completed, so its timestamps are available.
+	if (renderer_state.timestamp_query_pool && renderer_state.timestamps_written[current_frame])
+	{
+		uint64_t timestamps[2];
+
+		vk::Result r = renderer_state.device->logical_device.getQueryPoolResults(
+			renderer_state.timestamp_query_pool,
+			2 * current_frame,
+			2,
+			sizeof(timestamps),
+			timestamps,
+			sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64
+		);
+
+		if (r == vk::Result::eSuccess)
+		{
+			uint64_t ticks = (timestamps[1] - timestamps[0]) & renderer_state.timestamp_mask;
+
+			renderer_state.last_gpu_frame_time = static_cast<uint64_t>(
+				ticks * static_cast<double>(renderer_state.device->physical_device_properties.limits.timestampPeriod)
+			);
+		}
+	}
+
 	// Acquire next image in swapchain
 	auto next_image_index = renderer_state.swapchain->acquire_next_image_index(
 		UINT64_MAX, 
@@ -301,11 +385,23 @@ bool renderer_begin_frame()
 
 	renderer_state.current_image_index = *next_image_index;
 
+	renderer_state.last_wait_time = wait_clock.get_elapsed_time();
+
 	// Begin command buffer
 	CommandBuffer* command_buffer = renderer_state.graphics_command_buffers[current_frame].get();
 	command_buffer->reset();
 	command_buffer->begin(false, false, false);
 
+	if (renderer_state.timestamp_query_pool)
+	{
+		command_buffer->handle.resetQueryPool(renderer_state.timestamp_query_pool, 2 * current_frame, 2);
+		command_buffer->handle.writeTimestamp(
+			vk::PipelineStageFlagBits::eTopOfPipe,
+			renderer_state.timestamp_query_pool,
+			2 * current_frame
+		);
+	}
+
 	// Dynamic state
 	vk::Viewport viewport;
 	viewport.x = 0.0f;
@@ -324,6 +420,8 @@ bool renderer_begin_frame()
 	command_buffer->handle.setViewport(0, 1, &viewport);
 	command_buffer->handle.setScissor(0, 1, &scissor);
 
+	upload_voxel_materials(command_buffer);
+
 	transition_swapchain_image_to_trace(command_buffer, renderer_state.current_image_index);
 
 	renderer_state.voxel_shader->bind(command_buffer, renderer_state.current_image_index);
@@ -344,6 +442,15 @@ bool renderer_end_frame()
 
 	transition_swapchain_image_to_present(command_buffer, renderer_state.current_image_index);
 
+	if (renderer_state.timestamp_query_pool)
+	{
+		command_buffer->handle.writeTimestamp(
+			vk::PipelineStageFlagBits::eBottomOfPipe,
+			renderer_state.timestamp_query_pool,
+			2 * current_frame + 1
+		);
+	}
+
 	command_buffer->end();
 
 	// Wait if a previous frame is still using this image.
@@ -384,6 +491,8 @@ bool renderer_end_frame()
 
 	command_buffer->set_state(CommandBufferState::SUBMITTED);
 
+	renderer_state.timestamps_written[current_frame] = true;
+
 	bool present_successful = renderer_state.swapchain->present(
 		renderer_state.queue_complete_semaphores[renderer_state.swapchain->current_frame],
 		renderer_state.current_image_index
@@ -400,6 +509,64 @@ bool renderer_end_frame()
 	return true;
 }
 
+bool renderer_set_voxel_material_table(VoxelMaterialTable* material_table)
+{
+	uint32_t material_count = std::max<uint32_t>(material_table->get_material_count(), 1);
+
+	// Lay the arrays out back to back, each starting at an offset the device can bind.
+	vk::DeviceSize alignment = std::max<vk::DeviceSize>(
+		renderer_state.device->physical_device_properties.limits.minStorageBufferOffsetAlignment,
+		16
+	);
+
+	vk::DeviceSize element_sizes[(size_t) VoxelShaderMaterialArray::MAX_ENUM] = {
+		sizeof(vector4f), sizeof(float), sizeof(uint32_t)
+	};
+
+	vk::DeviceSize buffer_size = 0;
+
+	for (size_t i = 0; i < renderer_state.voxel_material_ranges.size(); i++)
+	{
+		renderer_state.voxel_material_ranges[i].offset = buffer_size;
+		renderer_state.voxel_material_ranges[i].range = element_sizes[i] * material_count;
+
+		buffer_size += (renderer_state.voxel_material_ranges[i].range + alignment - 1) / alignment * alignment;
+	}
+
+	// Wait for the device to idle before replacing a buffer that may still be in use.
+	vk::Result r = renderer_state.device->logical_device.waitIdle();
+
+	if (r != vk::Result::eSuccess)
+	{
+		sl::log_error("Failed to wait for device to idle.");
+		return false;
+	}
+
+	renderer_state.voxel_material_buffer = VulkanBuffer::create(
+		renderer_state.device,
+		buffer_size,
+		vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+		vk::MemoryPropertyFlagBits::eDeviceLocal
+	);
+
+	if (!renderer_state.voxel_material_buffer)
+	{
+		sl::log_error("Failed to create the voxel material buffer.");
+		return false;
+	}
+
+	renderer_state.voxel_shader->update_material_descriptor_sets(
+		renderer_state.voxel_material_buffer.get(),
+		renderer_state.voxel_material_ranges
+	);
+
+	// Upload the whole table with the next frame.
+	renderer_state.voxel_material_table = material_table;
+	renderer_state.voxel_material_table->mark_dirty(0, material_table->get_material_count());
+
+	return true;
+}
+
 vector2ui renderer_get_framebuffer_size()
 {
 	return vector2ui {
@@ -408,6 +575,16 @@ vector2ui renderer_get_framebuffer_size()
 	};
 }
 
+std::optional<uint64_t> renderer_get_last_gpu_frame_time()
+{
+	return renderer_state.last_gpu_frame_time;
+}
+
+uint64_t renderer_get_last_wait_time()
+{
+	return renderer_state.last_wait_time;
+}
+
 static bool check_validation_layer_support()
 {
 	// Get available validation layers.
@@ -544,3 +721,63 @@ static void transition_swapchain_image_to_present(CommandBuffer* cb, uint32_t im
 		1, &barrier
 	);
 }
+
+static void upload_voxel_materials(CommandBuffer* cb)
+{
+	VoxelMaterialTable* table = renderer_state.voxel_material_table;
+
+	if (!table || !table->is_dirty())
+	{
+		return;
+	}
+
+	// Previous frames may still be reading the materials.
+	cb->handle.pipelineBarrier(
+		vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eTransfer,
+		{},
+		0, nullptr,
+		0, nullptr,
+		0, nullptr
+	);
+
+	const void* arrays[(size_t) VoxelShaderMaterialArray::MAX_ENUM] = {
+		table->colors.data(), table->emissive.data(), table->flags.data()
+	};
+
+	vk::DeviceSize element_sizes[(size_t) VoxelShaderMaterialArray::MAX_ENUM] = {
+		sizeof(vector4f), sizeof(float), sizeof(uint32_t)
+	};
+
+	// Only upload the range of materials that changed.
+	for (size_t i = 0; i < renderer_state.voxel_material_ranges.size(); i++)
+	{
+		renderer_state.voxel_material_buffer->update(
+			cb,
+			renderer_state.voxel_material_ranges[i].offset + table->dirty_begin * element_sizes[i],
+			(table->dirty_end - table->dirty_begin) * element_sizes[i],
+			static_cast<const uint8_t*>(arrays[i]) + table->dirty_begin * element_sizes[i]
+		);
+	}
+
+	table->clear_dirty();
+
+	vk::BufferMemoryBarrier barrier(
+		vk::AccessFlagBits::eTransferWrite,
+		vk::AccessFlagBits::eShaderRead,
+		VK_QUEUE_FAMILY_IGNORED,
+		VK_QUEUE_FAMILY_IGNORED,
+		renderer_state.voxel_material_buffer->handle,
+		0,
+		VK_WHOLE_SIZE
+	);
+
+	cb->handle.pipelineBarrier(
+		vk::PipelineStageFlagBits::eTransfer,
+		vk::PipelineStageFlagBits::eComputeShader,
+		{},
+		0, nullptr,
+		1, &barrier,
+		0, nullptr
+	);
+}
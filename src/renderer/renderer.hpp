@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+
 #include <math/vector2.hpp>
 
+#include "voxel/voxel_material_table.hpp"
+
 bool renderer_initialize();
 
 void renderer_shutdown();
@@ -11,3 +16,27 @@ bool renderer_begin_frame();
 bool renderer_end_frame();
 
 vector2ui renderer_get_framebuffer_size();
+
+/**
+ * @brief Returns how long the GPU spent executing the most recently completed frame, in nanoseconds.
+ * 
+ * Frames complete up to the amount of frames in flight after they are submitted, so this lags behind the frame that is
+ * being recorded.
+ * 
+ * @return std::nullopt if the device doesn't support timestamps, or no frame has completed yet.
+ */
+std::optional<uint64_t> renderer_get_last_gpu_frame_time();
+
+/**
+ * @brief Returns how long the last \ref renderer_begin_frame blocked waiting for a frame in flight and a swapchain image,
+ * in nanoseconds.
+ */
+uint64_t renderer_get_last_wait_time();
+
+/**
+ * @brief Creates the GPU material buffer for a material table and binds it to the voxel shader.
+ *
+ * The dirty range of the table is uploaded at the start of every frame, so later changes to the table only upload the
+ * materials that changed. The table must outlive the renderer.
+ */
+bool renderer_set_voxel_material_table(VoxelMaterialTable* material_table);
@@ -22,16 +22,29 @@ std::unique_ptr<VoxelShader> VoxelShader::create(
     }
 
     // Create uniform descriptor set layouts.
-    vk::DescriptorSetLayoutBinding color_buffer_binding(
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+    bindings.emplace_back(
         0,
         vk::DescriptorType::eStorageImage,
         1,
         vk::ShaderStageFlagBits::eCompute
     );
 
+    // One storage buffer binding per material array.
+    for (uint32_t i = 0; i < (uint32_t) VoxelShaderMaterialArray::MAX_ENUM; i++)
+    {
+        bindings.emplace_back(
+            i + 1,
+            vk::DescriptorType::eStorageBuffer,
+            1,
+            vk::ShaderStageFlagBits::eCompute
+        );
+    }
+
     vk::DescriptorSetLayoutCreateInfo uniform_descriptor_set_ci(
         {},
-        1, &color_buffer_binding
+        bindings
     );
 
     vk::Result r;
@@ -46,16 +59,22 @@ std::unique_ptr<VoxelShader> VoxelShader::create(
     }
 
     // Create uniform descriptor pool.
-    vk::DescriptorPoolSize pool_size(
-        vk::DescriptorType::eStorageImage,
-        swapchain_image_count
-    );
+    vk::DescriptorPoolSize pool_sizes[2] = {
+        vk::DescriptorPoolSize(
+            vk::DescriptorType::eStorageImage,
+            swapchain_image_count
+        ),
+        vk::DescriptorPoolSize(
+            vk::DescriptorType::eStorageBuffer,
+            swapchain_image_count * (uint32_t) VoxelShaderMaterialArray::MAX_ENUM
+        )
+    };
 
     vk::DescriptorPoolCreateInfo pool_ci(
         {},
         swapchain_image_count,
-        1,
-        &pool_size
+        2,
+        pool_sizes
     );
 
     std::tie(r, out->uniform_descriptor_pool) = device->logical_device.createDescriptorPool(pool_ci);
@@ -142,3 +161,30 @@ void VoxelShader::update_color_buffer_descriptor_sets(const Swapchain* swapchain
 
     device->logical_device.updateDescriptorSets(write_ops, nullptr);
 }
+
+void VoxelShader::update_material_descriptor_sets(
+    const VulkanBuffer* material_buffer,
+    const std::array<vk::DescriptorBufferInfo, (size_t) VoxelShaderMaterialArray::MAX_ENUM>& ranges
+)
+{
+    std::array<vk::DescriptorBufferInfo, (size_t) VoxelShaderMaterialArray::MAX_ENUM> buffer_infos = ranges;
+
+    for (auto& buffer_info : buffer_infos)
+    {
+        buffer_info.buffer = material_buffer->handle;
+    }
+
+    std::vector<vk::WriteDescriptorSet> write_ops(uniform_descriptor_sets.size());
+
+    for (uint32_t i = 0; i < uniform_descriptor_sets.size(); i++)
+    {
+        // The material arrays occupy consecutive bindings, so a single write covers all of them.
+        write_ops[i].dstSet = uniform_descriptor_sets[i];
+        write_ops[i].dstBinding = 1;
+        write_ops[i].descriptorCount = buffer_infos.size();
+        write_ops[i].descriptorType = vk::DescriptorType::eStorageBuffer;
+        write_ops[i].pBufferInfo = buffer_infos.data();
+    }
+
+    device->logical_device.updateDescriptorSets(write_ops, nullptr);
+}
@@ -3,6 +3,21 @@
 #include "renderer/swapchain.hpp"
 #include "renderer/pipeline.hpp"
 #include "renderer/shader_stage.hpp"
+#include "renderer/vulkan_buffer.hpp"
+
+#include <array>
+
+/**
+ * @brief The material arrays bound to the voxel shader, in binding order starting at binding 1.
+ */
+enum class VoxelShaderMaterialArray
+{
+    COLOR,
+    EMISSIVE,
+    FLAGS,
+
+    MAX_ENUM
+};
 
 struct VoxelShader
 {
@@ -30,5 +45,17 @@ struct VoxelShader
 
     void update_color_buffer_descriptor_sets(const Swapchain* swapchain);
 
+    /**
+     * @brief Binds the material arrays to every descriptor set.
+     *
+     * @param material_buffer The buffer containing all material arrays.
+     * @param ranges The offset and size of every material array within the buffer, indexed by
+     * \ref VoxelShaderMaterialArray.
+     */
+    void update_material_descriptor_sets(
+        const VulkanBuffer* material_buffer,
+        const std::array<vk::DescriptorBufferInfo, (size_t) VoxelShaderMaterialArray::MAX_ENUM>& ranges
+    );
+
     void bind(const CommandBuffer* cb, uint32_t current_image_index);
 };
@@ -0,0 +1,117 @@
+#include "renderer/vulkan_buffer.hpp"
+
+#include <algorithm>
+
+#include <simple-logger.hpp>
+
+// The maximum amount of bytes a single vkCmdUpdateBuffer call may write.
+#define MAX_INLINE_UPDATE_SIZE 65536
+
+std::unique_ptr<VulkanBuffer> VulkanBuffer::create(
+	const Device* device,
+	vk::DeviceSize size,
+	vk::BufferUsageFlags usage,
+	vk::MemoryPropertyFlags memory_flags
+)
+{
+	auto out = std::make_unique<VulkanBuffer>();
+
+	// Copy trivial data.
+	out->device = device;
+	out->size = size;
+	out->usage = usage;
+
+	vk::BufferCreateInfo buffer_create_info(
+		{},
+		size,
+		usage,
+		vk::SharingMode::eExclusive
+	);
+
+	vk::Result r;
+
+	std::tie(r, out->handle) = device->logical_device.createBuffer(buffer_create_info);
+
+	if (r != vk::Result::eSuccess)
+	{
+		sl::log_error("Failed to create buffer object.");
+		return nullptr;
+	}
+
+	// Query memory requirements
+	vk::MemoryRequirements memory_reqs = device->logical_device.getBufferMemoryRequirements(out->handle);
+
+	// Get memory type index
+	vk::PhysicalDeviceMemoryProperties memory_properties = device->physical_device_memory_properties;
+
+	int32_t memory_type = -1;
+	for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+	{
+		if (memory_reqs.memoryTypeBits & (1 << i) &&
+			(memory_properties.memoryTypes[i].propertyFlags & memory_flags) == memory_flags &&
+			static_cast<uint32_t>(
+				memory_properties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceCoherentAMD
+			) == 0
+		)
+		{
+			memory_type = i;
+		}
+	}
+
+	if (memory_type == -1)
+	{
+		sl::log_error("Required memory type was not found.");
+		return nullptr;
+	}
+
+	// Allocate memory
+	vk::MemoryAllocateInfo memory_allocate_info(
+		memory_reqs.size,
+		memory_type
+	);
+
+	std::tie(r, out->memory) = device->logical_device.allocateMemory(memory_allocate_info);
+
+	if (r != vk::Result::eSuccess)
+	{
+		sl::log_error("Failed to allocate memory for buffer.");
+		return nullptr;
+	}
+
+	// Bind memory
+	r = device->logical_device.bindBufferMemory(out->handle, out->memory, 0);
+
+	if (r != vk::Result::eSuccess)
+	{
+		sl::log_error("Failed to bind memory to buffer handle.");
+		return nullptr;
+	}
+
+	return out;
+}
+
+VulkanBuffer::~VulkanBuffer()
+{
+	if (memory)
+	{
+		device->logical_device.freeMemory(memory);
+	}
+
+	if (handle)
+	{
+		device->logical_device.destroy(handle);
+	}
+}
+
+void VulkanBuffer::update(const CommandBuffer* cb, vk::DeviceSize offset, vk::DeviceSize size, const void* data)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+	// Split the update into the largest chunks vkCmdUpdateBuffer accepts.
+	for (vk::DeviceSize written = 0; written < size; written += MAX_INLINE_UPDATE_SIZE)
+	{
+		vk::DeviceSize chunk_size = std::min<vk::DeviceSize>(size - written, MAX_INLINE_UPDATE_SIZE);
+
+		cb->handle.updateBuffer(handle, offset + written, chunk_size, bytes + written);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "renderer/device.hpp"
+#include "renderer/command_buffer.hpp"
+
+struct VulkanBuffer
+{
+	vk::Buffer handle;
+
+	vk::DeviceMemory memory;
+
+	vk::DeviceSize size;
+
+	vk::BufferUsageFlags usage;
+
+	const Device* device;
+
+	VulkanBuffer() = default;
+
+	VulkanBuffer(VulkanBuffer&) = delete; // Prevent copies.
+
+	~VulkanBuffer();
+
+	VulkanBuffer& operator = (const VulkanBuffer&) = delete; // Prevent copies.
+
+	static std::unique_ptr<VulkanBuffer> create(
+		const Device* device,
+		vk::DeviceSize size,
+		vk::BufferUsageFlags usage,
+		vk::MemoryPropertyFlags memory_flags
+	);
+
+	/**
+	 * @brief Records an inline update of the buffer contents into a command buffer.
+	 *
+	 * The data is copied into the command buffer while recording, so it does not have to outlive this call. The
+	 * buffer must have been created with the transfer destination usage. Both the offset and size must be multiples of
+	 * 4.
+	 */
+	void update(const CommandBuffer* command_buffer, vk::DeviceSize offset, vk::DeviceSize size, const void* data);
+};
@@ -0,0 +1,105 @@
+#include "tick_scheduler.hpp"
+
+#include <algorithm>
+
+#include "clock.hpp"
+#include "platform/platform.hpp"
+#include "profiler.hpp"
+
+TickScheduler TickScheduler::create(uint32_t tick_rate, uint32_t max_ticks_per_update)
+{
+	TickScheduler out;
+
+	out.tick_duration = 1'000'000'000 / std::max<uint32_t>(tick_rate, 1);
+	out.max_ticks_per_update = std::max<uint32_t>(max_ticks_per_update, 1);
+	out.accumulator = 0;
+	out.tick_count = 0;
+	out.dropped_time = 0;
+
+	return out;
+}
+
+uint32_t TickScheduler::advance(uint64_t elapsed_ns)
+{
+	accumulator += elapsed_ns;
+
+	uint64_t due_ticks = accumulator / tick_duration;
+
+	if (due_ticks > max_ticks_per_update)
+	{
+		// Drop whole ticks only, so the alpha stays continuous.
+		uint64_t dropped = (due_ticks - max_ticks_per_update) * tick_duration;
+
+		accumulator -= dropped;
+		dropped_time += dropped;
+
+		due_ticks = max_ticks_per_update;
+	}
+
+	accumulator -= due_ticks * tick_duration;
+	tick_count += due_ticks;
+
+	return static_cast<uint32_t>(due_ticks);
+}
+
+float TickScheduler::get_alpha() const
+{
+	return static_cast<float>(static_cast<double>(accumulator) / static_cast<double>(tick_duration));
+}
+
+uint64_t TickScheduler::get_time_until_next_tick() const
+{
+	return tick_duration - accumulator;
+}
+
+std::unique_ptr<TickThread> TickThread::create(TickScheduler scheduler, TickCallback callback)
+{
+	auto out = std::make_unique<TickThread>();
+
+	out->scheduler = scheduler;
+	out->callback = std::move(callback);
+	out->stopping.store(false, std::memory_order_relaxed);
+
+	out->thread = std::thread(&TickThread::run, out.get());
+
+	return out;
+}
+
+TickThread::~TickThread()
+{
+	if (thread.joinable())
+	{
+		stopping.store(true, std::memory_order_relaxed);
+
+		thread.join();
+	}
+}
+
+void TickThread::run()
+{
+	profiler_set_thread_name("simulation");
+
+	Clock clock;
+	clock.reset();
+
+	while (!stopping.load(std::memory_order_relaxed))
+	{
+		uint32_t tick_count = scheduler.advance(clock.restart());
+
+		for (uint32_t i = 0; i < tick_count; i++)
+		{
+			PROFILE_SCOPE("tick");
+
+			callback(scheduler.tick_count - tick_count + i);
+		}
+
+		// Sleep until the next tick is due. The time spent ticking already counts towards it.
+		uint64_t elapsed = clock.get_elapsed_time();
+		uint64_t until_next_tick = scheduler.get_time_until_next_tick();
+
+		if (until_next_tick > elapsed)
+		{
+			platform_sleep_until(platform_get_time_ns() + until_next_tick - elapsed);
+		}
+	}
+}
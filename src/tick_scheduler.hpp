@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+/**
+ * @brief Turns variable frame times into a fixed amount of simulation ticks.
+ *
+ * Elapsed time accumulates until it covers whole ticks. The time left over is less than a tick, and its fraction of a
+ * tick is the alpha to interpolate rendered state between the previous and the current tick with.
+ */
+struct TickScheduler
+{
+	// The duration of a tick in nanoseconds.
+	uint64_t tick_duration;
+
+	// The most ticks a single update runs. When the simulation falls further behind, the excess time is dropped and
+	// the simulation slows down instead of spending ever longer catching up.
+	uint32_t max_ticks_per_update;
+
+	// Elapsed time that is not yet covered by ticks.
+	uint64_t accumulator;
+
+	// The amount of ticks run so far.
+	uint64_t tick_count;
+
+	// The total time dropped by the catch-up cap.
+	uint64_t dropped_time;
+
+	/**
+	 * @param tick_rate Ticks per second.
+	 */
+	static TickScheduler create(uint32_t tick_rate, uint32_t max_ticks_per_update);
+
+	/**
+	 * @brief Adds elapsed time, returning how many ticks should run now.
+	 */
+	uint32_t advance(uint64_t elapsed_ns);
+
+	/**
+	 * @brief Returns how far the time since the last tick is into the next one, in the range [0, 1).
+	 */
+	float get_alpha() const;
+
+	/**
+	 * @brief Returns how long until the next tick is due, in nanoseconds.
+	 */
+	uint64_t get_time_until_next_tick() const;
+};
+
+/**
+ * @brief Runs a single tick. Receives the index of the tick, starting at 0.
+ */
+typedef std::function<void(uint64_t tick)> TickCallback;
+
+/**
+ * @brief Runs ticks on their own thread, so their cost doesn't depend on the render frame rate or vice versa.
+ *
+ * The callback owns the simulated state. It typically hands a copy of it to the render thread through a
+ * \ref TripleBuffer after every tick.
+ */
+struct TickThread
+{
+	TickScheduler scheduler;
+
+	TickCallback callback;
+
+	std::atomic<bool> stopping;
+
+	std::thread thread;
+
+	TickThread() = default;
+
+	TickThread(const TickThread&) = delete; // Prevent copies.
+
+	~TickThread();
+
+	TickThread& operator = (const TickThread&) = delete; // Prevent copies.
+
+	static std::unique_ptr<TickThread> create(TickScheduler scheduler, TickCallback callback);
+
+	void run();
+};
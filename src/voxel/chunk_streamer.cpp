@@ -0,0 +1,357 @@
+#include "voxel/chunk_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "profiler.hpp"
+
+// The amount of updates usage has to stay below three quarters of the budget before the window grows by a chunk.
+static constexpr uint32_t BUDGET_RELAX_UPDATES = 60;
+
+// The amount of updates before a failed chunk is requested again, doubled with every further failure.
+static constexpr uint64_t FAILED_RETRY_UPDATES = 16;
+static constexpr uint64_t FAILED_RETRY_MAX_UPDATES = 1024;
+
+std::unique_ptr<ChunkStreamer> ChunkStreamer::create(
+    VoxelGrid* grid,
+    ChunkGenerator generator,
+    uint32_t worker_count,
+    int32_t view_distance,
+    uint64_t memory_budget
+)
+{
+    auto out = std::make_unique<ChunkStreamer>();
+
+    out->grid = grid;
+    out->generator = std::move(generator);
+    out->view_distance = view_distance;
+    out->memory_budget = memory_budget;
+    out->budget_distance = std::numeric_limits<float>::infinity();
+
+    out->camera_chunk = vector3i { 0, 0, 0 };
+    out->camera_direction = vector3f { 0.0f, 0.0f, 1.0f };
+
+    worker_count = std::max<uint32_t>(worker_count, 1);
+
+    for (uint32_t i = 0; i < worker_count; i++)
+    {
+        out->workers.emplace_back(&ChunkStreamer::run_worker, out.get());
+    }
+
+    return out;
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    {
+        std::lock_guard lock(mutex);
+
+        stopping = true;
+    }
+
+    work_available.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ChunkStreamer::update(vector3f camera_position, vector3f view_direction)
+{
+    PROFILE_SCOPE("stream chunks");
+
+    update_count++;
+
+    vector3i new_camera_chunk = grid->get_chunk_position(vector3i {
+        static_cast<int>(std::floor(camera_position.x)),
+        static_cast<int>(std::floor(camera_position.y)),
+        static_cast<int>(std::floor(camera_position.z))
+    });
+
+    float direction_similarity =
+        view_direction.x * camera_direction.x +
+        view_direction.y * camera_direction.y +
+        view_direction.z * camera_direction.z;
+
+    // Only reprioritize when the camera moved to another chunk or turned considerably.
+    if (new_camera_chunk != camera_chunk || direction_similarity < 0.9f)
+    {
+        camera_chunk = new_camera_chunk;
+        camera_direction = view_direction;
+
+        window_dirty = true;
+    }
+
+    integrate_completed_chunks();
+
+    evict_chunks();
+
+    if (update_count >= next_retry_update)
+    {
+        window_dirty = true;
+    }
+
+    if (window_dirty)
+    {
+        schedule_missing_chunks();
+
+        window_dirty = false;
+    }
+}
+
+void ChunkStreamer::integrate_completed_chunks()
+{
+    std::vector<std::pair<vector3i, std::optional<VoxelOctree>>> chunks;
+
+    {
+        std::lock_guard lock(mutex);
+
+        chunks.swap(completed);
+
+        for (auto& chunk : chunks)
+        {
+            in_flight.erase(chunk.first);
+        }
+    }
+
+    for (auto& [chunk_position, octree] : chunks)
+    {
+        if (!octree.has_value())
+        {
+            // Failed to produce the chunk, request it again later rather than retrying a failing generator at once.
+            ChunkStreamerFailure& failure = failed[chunk_position];
+
+            uint64_t delay = std::min(FAILED_RETRY_UPDATES << std::min<uint32_t>(failure.attempts, 16),
+                FAILED_RETRY_MAX_UPDATES);
+
+            failure.attempts++;
+            failure.retry_update = update_count + delay;
+
+            next_retry_update = std::min(next_retry_update, failure.retry_update);
+            continue;
+        }
+
+        failed.erase(chunk_position);
+
+        // The camera may have moved away while the chunk was being generated.
+        float distance = get_chunk_distance(chunk_position);
+
+        if (distance > view_distance || distance >= budget_distance)
+        {
+            continue;
+        }
+
+        grid->insert_octree(chunk_position, std::move(*octree));
+    }
+}
+
+void ChunkStreamer::evict_chunks()
+{
+    struct ResidentChunk
+    {
+        vector3i chunk_position;
+        float distance;
+        uint64_t memory_usage;
+    };
+
+    std::vector<vector3i> evicted;
+    std::vector<ResidentChunk> resident;
+
+    resident_memory = 0;
+
+    for (auto& [chunk_position, octree_handle] : grid->octree_coordinates)
+    {
+        float distance = get_chunk_distance(chunk_position);
+
+        // Keep a margin of one chunk, so chunks on the edge of the window don't get evicted and requested repeatedly.
+        if (distance > view_distance + 1)
+        {
+            evicted.push_back(chunk_position);
+            continue;
+        }
+
+        uint64_t memory_usage = (*grid->octrees.get(octree_handle))->get_memory_usage();
+
+        resident_memory += memory_usage;
+        resident.push_back({ chunk_position, distance, memory_usage });
+    }
+
+    if (resident_memory > memory_budget)
+    {
+        // Evict the farthest chunks first, and stop requesting chunks at that distance.
+        std::sort(resident.begin(), resident.end(), [](const ResidentChunk& a, const ResidentChunk& b) {
+            return a.distance > b.distance;
+        });
+
+        for (auto& chunk : resident)
+        {
+            if (resident_memory <= memory_budget) break;
+
+            evicted.push_back(chunk.chunk_position);
+            resident_memory -= chunk.memory_usage;
+
+            budget_distance = std::min(budget_distance, chunk.distance);
+        }
+
+        low_memory_updates = 0;
+    }
+    else if (resident_memory < memory_budget / 4 * 3 && budget_distance != std::numeric_limits<float>::infinity())
+    {
+        // Grow the window again one chunk at a time, and only once usage stayed low for a while. Growing it all at
+        // once regenerates the chunks that were just evicted, only to evict them again.
+        if (++low_memory_updates >= BUDGET_RELAX_UPDATES)
+        {
+            low_memory_updates = 0;
+            budget_distance += 1.0f;
+
+            if (budget_distance > view_distance)
+            {
+                budget_distance = std::numeric_limits<float>::infinity();
+            }
+
+            window_dirty = true;
+        }
+    }
+    else
+    {
+        low_memory_updates = 0;
+    }
+
+    for (auto& chunk_position : evicted)
+    {
+        if (evictor)
+        {
+            evictor(chunk_position, *grid->get_octree(chunk_position).value());
+        }
+
+        grid->remove_octree(chunk_position);
+    }
+}
+
+void ChunkStreamer::schedule_missing_chunks()
+{
+    std::vector<ChunkStreamerRequest> requests;
+
+    // Forget failures that left the window, and find the next failure to retry.
+    next_retry_update = UINT64_MAX;
+
+    for (auto it = failed.begin(); it != failed.end();)
+    {
+        if (get_chunk_distance(it->first) > view_distance)
+        {
+            it = failed.erase(it);
+            continue;
+        }
+
+        if (it->second.retry_update > update_count)
+        {
+            next_retry_update = std::min(next_retry_update, it->second.retry_update);
+        }
+
+        it++;
+    }
+
+    for (int32_t z = -view_distance; z <= view_distance; z++)
+    {
+        for (int32_t y = -view_distance; y <= view_distance; y++)
+        {
+            for (int32_t x = -view_distance; x <= view_distance; x++)
+            {
+                vector3i chunk_position = camera_chunk + vector3i { x, y, z };
+
+                float distance = get_chunk_distance(chunk_position);
+
+                if (distance > view_distance || distance >= budget_distance)
+                {
+                    continue;
+                }
+
+                if (grid->get_octree(chunk_position).has_value())
+                {
+                    continue;
+                }
+
+                auto failure = failed.find(chunk_position);
+
+                if (failure != failed.end() && failure->second.retry_update > update_count)
+                {
+                    continue;
+                }
+
+                // Chunks in front of the camera are up to twice as urgent as chunks behind it.
+                float facing = distance > 0.0f
+                    ? (x * camera_direction.x + y * camera_direction.y + z * camera_direction.z) / distance
+                    : 1.0f;
+
+                requests.push_back({ chunk_position, distance * (1.5f - 0.5f * facing) });
+            }
+        }
+    }
+
+    std::sort(requests.begin(), requests.end(), [](const ChunkStreamerRequest& a, const ChunkStreamerRequest& b) {
+        return a.priority > b.priority;
+    });
+
+    {
+        std::lock_guard lock(mutex);
+
+        // Replace the queue, dropping requests that fell out of the window.
+        pending.clear();
+
+        for (auto& request : requests)
+        {
+            if (!in_flight.contains(request.chunk_position))
+            {
+                pending.push_back(request);
+            }
+        }
+    }
+
+    work_available.notify_all();
+}
+
+float ChunkStreamer::get_chunk_distance(vector3i chunk_position) const
+{
+    vector3i offset = chunk_position - camera_chunk;
+
+    return std::sqrt(static_cast<float>(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z));
+}
+
+void ChunkStreamer::run_worker()
+{
+    profiler_set_thread_name("chunk worker");
+
+    while (true)
+    {
+        ChunkStreamerRequest request;
+
+        {
+            std::unique_lock lock(mutex);
+
+            work_available.wait(lock, [this] { return stopping || !pending.empty(); });
+
+            if (stopping) return;
+
+            request = pending.back();
+            pending.pop_back();
+
+            in_flight.insert(request.chunk_position);
+        }
+
+        std::optional<VoxelOctree> octree;
+
+        {
+            PROFILE_SCOPE("produce chunk");
+
+            octree = generator(request.chunk_position, grid->octree_depth);
+        }
+
+        {
+            std::lock_guard lock(mutex);
+
+            completed.emplace_back(request.chunk_position, std::move(octree));
+        }
+    }
+}
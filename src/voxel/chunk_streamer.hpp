@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "voxel/voxel_grid.hpp"
+
+/**
+ * @brief Generates or loads the octree of a chunk. Called from worker threads, so it must be thread safe.
+ *
+ * @return std::nullopt if the chunk could not be produced. It will be requested again later, backing off after every
+ * failure.
+ */
+typedef std::function<std::optional<VoxelOctree>(vector3i chunk_position, uint8_t depth)> ChunkGenerator;
+
+/**
+ * @brief Called with every chunk right before it is evicted from the grid, e.g. to save it.
+ */
+typedef std::function<void(vector3i chunk_position, const VoxelOctree& octree)> ChunkEvictor;
+
+struct ChunkStreamerFailure
+{
+    uint32_t attempts;
+
+    // The update from which on the chunk is requested again.
+    uint64_t retry_update;
+};
+
+struct ChunkStreamerRequest
+{
+    vector3i chunk_position;
+    float priority; // Lower is more urgent.
+};
+
+/**
+ * @brief Keeps the chunks of a \ref VoxelGrid around a camera resident.
+ *
+ * Missing chunks within the view distance are produced by a \ref ChunkGenerator on background threads, closest and
+ * in view first. Chunks that leave the view distance are evicted, as are the farthest chunks whenever the grid
+ * exceeds its memory budget. All grid modifications happen on the thread that calls \ref update.
+ */
+struct ChunkStreamer
+{
+    VoxelGrid* grid;
+
+    ChunkGenerator generator;
+
+    // Optional.
+    ChunkEvictor evictor;
+
+    // The radius of the resident window in chunks.
+    int32_t view_distance;
+
+    // The amount of octree memory in bytes that the grid may use.
+    uint64_t memory_budget;
+
+    // Chunks beyond this distance are not requested, as they were evicted to stay within the memory budget.
+    float budget_distance;
+
+    // The amount of updates in a row that stayed well below the memory budget, to grow `budget_distance` again.
+    uint32_t low_memory_updates = 0;
+
+    uint64_t resident_memory = 0;
+
+    uint64_t update_count = 0;
+
+    // Chunks the generator failed to produce, which are not requested again until their retry update.
+    std::unordered_map<vector3i, ChunkStreamerFailure> failed;
+    uint64_t next_retry_update = UINT64_MAX;
+
+    vector3i camera_chunk;
+    vector3f camera_direction;
+    bool window_dirty = true;
+
+    // Worker state. Everything below is guarded by `mutex`.
+    std::mutex mutex;
+    std::condition_variable work_available;
+    bool stopping = false;
+
+    // Sorted from least to most urgent, so workers pop from the back.
+    std::vector<ChunkStreamerRequest> pending;
+    std::unordered_set<vector3i> in_flight;
+    std::vector<std::pair<vector3i, std::optional<VoxelOctree>>> completed;
+
+    std::vector<std::thread> workers;
+
+    ChunkStreamer() = default;
+
+    ChunkStreamer(const ChunkStreamer&) = delete; // Prevent copies.
+
+    ~ChunkStreamer();
+
+    ChunkStreamer& operator = (const ChunkStreamer&) = delete; // Prevent copies.
+
+    static std::unique_ptr<ChunkStreamer> create(
+        VoxelGrid* grid,
+        ChunkGenerator generator,
+        uint32_t worker_count,
+        int32_t view_distance,
+        uint64_t memory_budget
+    );
+
+    /**
+     * @brief Integrates finished chunks, evicts far chunks and schedules missing ones. Call once per frame.
+     *
+     * @param camera_position The camera position in voxels.
+     * @param view_direction The normalized view direction of the camera.
+     */
+    void update(vector3f camera_position, vector3f view_direction);
+
+private:
+    void integrate_completed_chunks();
+
+    void evict_chunks();
+
+    void schedule_missing_chunks();
+
+    float get_chunk_distance(vector3i chunk_position) const;
+
+    void run_worker();
+};
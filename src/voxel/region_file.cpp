@@ -0,0 +1,441 @@
+#include "voxel/region_file.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+
+#include <simple-logger.hpp>
+
+#include "profiler.hpp"
+
+// The header sector followed by the entry table.
+static constexpr uint32_t HEADER_SECTOR_COUNT =
+    1 + (REGION_CHUNK_COUNT * sizeof(RegionFileEntry) + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+
+// Don't bother compacting files with less garbage than this.
+static constexpr uint32_t MIN_COMPACTION_GARBAGE_SECTOR_COUNT = 256;
+
+static bool write_header(std::ostream& stream, const std::vector<RegionFileEntry>& entries);
+
+// Clears the entries that point outside the chunk data or overlap an earlier chunk, returning how many were cleared.
+static uint32_t clear_invalid_entries(std::vector<RegionFileEntry>& entries, uint32_t sector_count);
+
+std::unique_ptr<RegionFile> RegionFile::open(const std::string& path)
+{
+    auto out = std::make_unique<RegionFile>();
+
+    out->path = path;
+    out->entries.resize(REGION_CHUNK_COUNT, RegionFileEntry { 0, 0 });
+
+    if (!std::filesystem::exists(path))
+    {
+        std::ofstream new_file(path, std::ios::binary);
+
+        if (!new_file || !write_header(new_file, out->entries))
+        {
+            sl::log_error("Failed to create region file `{}`.", path);
+            return nullptr;
+        }
+    }
+
+    out->file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+    if (!out->file)
+    {
+        sl::log_error("Failed to open region file `{}`.", path);
+        return nullptr;
+    }
+
+    // Read the header and entry table. The chunks themselves are only touched when they are accessed.
+    RegionFileHeader header;
+
+    out->file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!out->file || header.magic != RegionFileHeader::MAGIC || header.version != RegionFileHeader::VERSION)
+    {
+        sl::log_error("Region file `{}` is corrupt or of an unsupported version.", path);
+        return nullptr;
+    }
+
+    out->file.seekg(REGION_SECTOR_SIZE);
+    out->file.read(reinterpret_cast<char*>(out->entries.data()), REGION_CHUNK_COUNT * sizeof(RegionFileEntry));
+
+    out->file.seekg(0, std::ios::end);
+    out->sector_count = static_cast<uint64_t>(out->file.tellg()) / REGION_SECTOR_SIZE;
+
+    if (!out->file || out->sector_count < HEADER_SECTOR_COUNT)
+    {
+        sl::log_error("Region file `{}` is truncated.", path);
+        return nullptr;
+    }
+
+    // A corrupt entry table would make chunks read past the file or from each other, so such entries are dropped.
+    // Their sectors count as garbage and are reclaimed by the next compaction.
+    std::vector<RegionFileEntry> stored_entries = out->entries;
+
+    if (uint32_t invalid_count = clear_invalid_entries(out->entries, out->sector_count); invalid_count > 0)
+    {
+        sl::log_warn("Dropped {} corrupt chunk entries from region file `{}`.", invalid_count, path);
+
+        for (uint32_t i = 0; i < REGION_CHUNK_COUNT; i++)
+        {
+            if (out->entries[i].sector_offset == stored_entries[i].sector_offset &&
+                out->entries[i].sector_count == stored_entries[i].sector_count) continue;
+
+            out->file.seekp(REGION_SECTOR_SIZE + i * sizeof(RegionFileEntry));
+            out->file.write(reinterpret_cast<const char*>(&out->entries[i]), sizeof(RegionFileEntry));
+        }
+
+        out->file.flush();
+
+        if (!out->file)
+        {
+            sl::log_error("Failed to clear the corrupt chunk entries of region file `{}`.", path);
+            return nullptr;
+        }
+    }
+
+    uint64_t used_sector_count = 0;
+
+    for (auto& entry : out->entries)
+    {
+        used_sector_count += entry.sector_count;
+    }
+
+    // Valid entries don't overlap and lie within the chunk data, so they never use more sectors than it has.
+    out->garbage_sector_count = static_cast<uint32_t>(out->sector_count - HEADER_SECTOR_COUNT - used_sector_count);
+
+    if (!out->remap())
+    {
+        return nullptr;
+    }
+
+    out->writer = std::thread(&RegionFile::run_writer, out.get());
+
+    return out;
+}
+
+RegionFile::~RegionFile()
+{
+    if (writer.joinable())
+    {
+        {
+            std::lock_guard lock(mutex);
+
+            stopping = true;
+        }
+
+        writes_changed.notify_all();
+
+        writer.join();
+    }
+}
+
+uint32_t RegionFile::get_chunk_index(vector3i local_chunk_position)
+{
+    return (local_chunk_position.z * REGION_SIZE + local_chunk_position.y) * REGION_SIZE + local_chunk_position.x;
+}
+
+std::optional<RegionFileChunk> RegionFile::get_chunk(vector3i local_chunk_position)
+{
+    std::lock_guard lock(mutex);
+
+    RegionFileEntry entry = entries[get_chunk_index(local_chunk_position)];
+
+    if (entry.sector_offset == 0)
+    {
+        return std::nullopt;
+    }
+
+    // Widened before adding, so offsets near the end of the 32-bit range can't wrap around.
+    uint64_t end = (static_cast<uint64_t>(entry.sector_offset) + entry.sector_count) * REGION_SECTOR_SIZE;
+
+    if (entry.sector_offset < HEADER_SECTOR_COUNT)
+    {
+        sl::log_error("Chunk {} of region file `{}` overlaps its header.", get_chunk_index(local_chunk_position), path);
+        return std::nullopt;
+    }
+
+    // The chunk may have been appended after the file was last mapped.
+    if (mapping_stale || mapping->size < end)
+    {
+        if (!remap()) return std::nullopt;
+    }
+
+    if (mapping->size < end)
+    {
+        sl::log_error("Chunk {} of region file `{}` lies past its end.", get_chunk_index(local_chunk_position), path);
+        return std::nullopt;
+    }
+
+    std::span<const uint8_t> data(
+        mapping->data + static_cast<uint64_t>(entry.sector_offset) * REGION_SECTOR_SIZE,
+        static_cast<uint64_t>(entry.sector_count) * REGION_SECTOR_SIZE
+    );
+
+    auto view = VoxelOctreeView::from_linear(data);
+
+    if (!view.has_value())
+    {
+        sl::log_error("Chunk {} of region file `{}` is corrupt.", get_chunk_index(local_chunk_position), path);
+        return std::nullopt;
+    }
+
+    return RegionFileChunk { *view, mapping };
+}
+
+void RegionFile::save_chunk(vector3i local_chunk_position, std::vector<uint8_t> linear_octree)
+{
+    {
+        std::lock_guard lock(mutex);
+
+        queued_writes.emplace_back(get_chunk_index(local_chunk_position), std::move(linear_octree));
+    }
+
+    writes_changed.notify_all();
+}
+
+void RegionFile::flush()
+{
+    std::unique_lock lock(mutex);
+
+    writes_changed.wait(lock, [this] { return queued_writes.empty() && !writing; });
+}
+
+bool RegionFile::remap()
+{
+    auto new_mapping = platform_map_file(path);
+
+    if (!new_mapping.has_value())
+    {
+        sl::log_error("Failed to map region file `{}`.", path);
+        return false;
+    }
+
+    // Chunks loaded from the previous mapping keep it alive, and it is unmapped once the last of them is released.
+    mapping = std::shared_ptr<const PlatformFileMapping>(
+        new PlatformFileMapping(*new_mapping),
+        [](const PlatformFileMapping* released) {
+            platform_unmap_file(*released);
+            delete released;
+        }
+    );
+
+    mapping_stale = false;
+
+    return true;
+}
+
+void RegionFile::run_writer()
+{
+    profiler_set_thread_name("region writer");
+
+    std::unique_lock lock(mutex);
+
+    while (true)
+    {
+        writes_changed.wait(lock, [this] { return stopping || !queued_writes.empty(); });
+
+        if (queued_writes.empty())
+        {
+            // Stopping, and every queued chunk has been written.
+            return;
+        }
+
+        auto writes = std::move(queued_writes);
+        queued_writes.clear();
+        writing = true;
+
+        lock.unlock();
+
+        for (auto& [chunk_idx, linear_octree] : writes)
+        {
+            PROFILE_SCOPE("write chunk");
+
+            write_chunk(chunk_idx, linear_octree);
+        }
+
+        uint32_t data_sector_count = sector_count - HEADER_SECTOR_COUNT;
+
+        if (garbage_sector_count >= MIN_COMPACTION_GARBAGE_SECTOR_COUNT && garbage_sector_count * 2 > data_sector_count)
+        {
+            PROFILE_SCOPE("compact region");
+
+            compact();
+        }
+
+        lock.lock();
+
+        writing = false;
+        writes_changed.notify_all();
+    }
+}
+
+void RegionFile::write_chunk(uint32_t chunk_idx, const std::vector<uint8_t>& linear_octree)
+{
+    // Only the writer thread changes the sector count, so it can be read without locking.
+    RegionFileEntry entry;
+    entry.sector_offset = sector_count;
+    entry.sector_count = (linear_octree.size() + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+
+    // Append the chunk, padded to whole sectors.
+    std::vector<char> padding(static_cast<uint64_t>(entry.sector_count) * REGION_SECTOR_SIZE - linear_octree.size(), 0);
+
+    file.seekp(static_cast<uint64_t>(entry.sector_offset) * REGION_SECTOR_SIZE);
+    file.write(reinterpret_cast<const char*>(linear_octree.data()), linear_octree.size());
+    file.write(padding.data(), padding.size());
+
+    // Update the entry only after the data is in place.
+    file.seekp(REGION_SECTOR_SIZE + chunk_idx * sizeof(RegionFileEntry));
+    file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    file.flush();
+
+    if (!file)
+    {
+        sl::log_error("Failed to write chunk {} to region file `{}`.", chunk_idx, path);
+
+        file.clear();
+        return;
+    }
+
+    std::lock_guard lock(mutex);
+
+    garbage_sector_count += entries[chunk_idx].sector_count;
+    entries[chunk_idx] = entry;
+    sector_count += entry.sector_count;
+}
+
+void RegionFile::compact()
+{
+    std::string compacted_path = path + ".tmp";
+
+    std::vector<RegionFileEntry> old_entries;
+
+    {
+        std::lock_guard lock(mutex);
+
+        old_entries = entries;
+    }
+
+    // Copy every live chunk into a new file, back to back.
+    std::vector<RegionFileEntry> new_entries(REGION_CHUNK_COUNT, RegionFileEntry { 0, 0 });
+    std::vector<char> buffer;
+
+    std::ofstream compacted(compacted_path, std::ios::binary | std::ios::trunc);
+
+    compacted.seekp(static_cast<uint64_t>(HEADER_SECTOR_COUNT) * REGION_SECTOR_SIZE);
+
+    uint32_t new_sector_count = HEADER_SECTOR_COUNT;
+
+    for (uint32_t i = 0; i < REGION_CHUNK_COUNT; i++)
+    {
+        if (old_entries[i].sector_offset == 0) continue;
+
+        buffer.resize(static_cast<uint64_t>(old_entries[i].sector_count) * REGION_SECTOR_SIZE);
+
+        file.seekg(static_cast<uint64_t>(old_entries[i].sector_offset) * REGION_SECTOR_SIZE);
+        file.read(buffer.data(), buffer.size());
+        compacted.write(buffer.data(), buffer.size());
+
+        new_entries[i] = RegionFileEntry { new_sector_count, old_entries[i].sector_count };
+        new_sector_count += old_entries[i].sector_count;
+    }
+
+    compacted.seekp(0);
+
+    if (!file || !compacted || !write_header(compacted, new_entries))
+    {
+        sl::log_error("Failed to compact region file `{}`.", path);
+
+        file.clear();
+        return;
+    }
+
+    compacted.close();
+
+    // Locked until the entries match the file again, as a chunk read in between would map the compacted file but
+    // locate chunks by the old entries.
+    std::lock_guard lock(mutex);
+
+    file.close();
+
+    // Replace the file. Existing mappings keep referring to the old file.
+    std::error_code error;
+    std::filesystem::rename(compacted_path, path, error);
+
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+    if (error)
+    {
+        sl::log_error("Failed to replace region file `{}` with its compacted version.", path);
+        return;
+    }
+
+    entries = std::move(new_entries);
+    sector_count = new_sector_count;
+    garbage_sector_count = 0;
+    mapping_stale = true;
+}
+
+static bool write_header(std::ostream& stream, const std::vector<RegionFileEntry>& entries)
+{
+    std::vector<char> header_sectors(static_cast<uint64_t>(HEADER_SECTOR_COUNT) * REGION_SECTOR_SIZE, 0);
+
+    RegionFileHeader header { RegionFileHeader::MAGIC, RegionFileHeader::VERSION };
+
+    std::memcpy(header_sectors.data(), &header, sizeof(header));
+    std::memcpy(header_sectors.data() + REGION_SECTOR_SIZE, entries.data(), entries.size() * sizeof(RegionFileEntry));
+
+    stream.write(header_sectors.data(), header_sectors.size());
+    stream.flush();
+
+    return static_cast<bool>(stream);
+}
+
+static uint32_t clear_invalid_entries(std::vector<RegionFileEntry>& entries, uint32_t sector_count)
+{
+    uint32_t invalid_count = 0;
+
+    for (auto& entry : entries)
+    {
+        if (entry.sector_offset == 0 && entry.sector_count == 0) continue;
+
+        uint64_t end = static_cast<uint64_t>(entry.sector_offset) + entry.sector_count;
+
+        if (entry.sector_offset < HEADER_SECTOR_COUNT || entry.sector_count == 0 || end > sector_count)
+        {
+            entry = RegionFileEntry { 0, 0 };
+            invalid_count++;
+        }
+    }
+
+    // Walk the chunks in file order, so overlaps are between neighbours. Of two overlapping chunks, the one later in
+    // the file (or later in the table, on a tie) is dropped.
+    std::vector<uint32_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    std::stable_sort(order.begin(), order.end(), [&entries](uint32_t a, uint32_t b) {
+        return entries[a].sector_offset < entries[b].sector_offset;
+    });
+
+    uint64_t previous_end = 0;
+
+    for (uint32_t chunk_idx : order)
+    {
+        RegionFileEntry& entry = entries[chunk_idx];
+
+        if (entry.sector_offset == 0) continue;
+
+        if (entry.sector_offset < previous_end)
+        {
+            entry = RegionFileEntry { 0, 0 };
+            invalid_count++;
+            continue;
+        }
+
+        previous_end = static_cast<uint64_t>(entry.sector_offset) + entry.sector_count;
+    }
+
+    return invalid_count;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform/platform.hpp"
+#include "voxel/voxel_octree.hpp"
+
+// The amount of chunks along every axis of a region.
+#define REGION_SIZE 32
+#define REGION_CHUNK_COUNT (REGION_SIZE * REGION_SIZE * REGION_SIZE)
+
+#define REGION_SECTOR_SIZE 4096
+
+/**
+ * @brief Stored in the first sector of a region file.
+ */
+struct RegionFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    static constexpr uint32_t MAGIC = 0x4E47'4552; // "REGN"
+    static constexpr uint32_t VERSION = 1;
+};
+
+/**
+ * @brief Locates a chunk within a region file. A sector offset of 0 means the chunk is not stored.
+ */
+struct RegionFileEntry
+{
+    uint32_t sector_offset;
+    uint32_t sector_count;
+};
+
+/**
+ * @brief A chunk read in place from a region file, along with the mapping it reads from.
+ */
+struct RegionFileChunk
+{
+    VoxelOctreeView view;
+
+    // Keeps the mapping alive for as long as the view is in use.
+    std::shared_ptr<const PlatformFileMapping> mapping;
+};
+
+/**
+ * @brief A file storing the linearized octrees of 32x32x32 chunks.
+ *
+ * The file starts with a \ref RegionFileHeader sector, followed by a table of \ref RegionFileEntry for every chunk and
+ * the chunk data. Every chunk occupies a whole amount of sectors, so the octrees in the memory mapped file are
+ * suitably aligned to be read in place.
+ *
+ * Saving happens on a background thread: updated chunks are appended to the end of the file, and the file is compacted
+ * once more than half of it consists of overwritten chunks. The file is mapped again whenever a chunk past the end of
+ * the current mapping is read. Chunks handed out by \ref get_chunk share ownership of their mapping, so they remain
+ * valid across saves and compactions, and superseded mappings are released once no chunk reads from them anymore.
+ */
+struct RegionFile
+{
+    std::string path;
+
+    // Guards everything below.
+    std::mutex mutex;
+
+    std::vector<RegionFileEntry> entries;
+
+    uint32_t sector_count;
+    uint32_t garbage_sector_count = 0;
+
+    std::shared_ptr<const PlatformFileMapping> mapping;
+    bool mapping_stale = true;
+
+    // Writer state.
+    std::condition_variable writes_changed;
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> queued_writes;
+    bool writing = false;
+    bool stopping = false;
+
+    std::fstream file;
+    std::thread writer;
+
+    RegionFile() = default;
+
+    RegionFile(const RegionFile&) = delete; // Prevent copies.
+
+    ~RegionFile();
+
+    RegionFile& operator = (const RegionFile&) = delete; // Prevent copies.
+
+    /**
+     * @brief Opens a region file, creating it if it doesn't exist.
+     */
+    static std::unique_ptr<RegionFile> open(const std::string& path);
+
+    static uint32_t get_chunk_index(vector3i local_chunk_position);
+
+    /**
+     * @brief Returns a view of a stored chunk straight from the mapped file.
+     *
+     * @param local_chunk_position The position of the chunk within the region, in the range [0, 32).
+     */
+    std::optional<RegionFileChunk> get_chunk(vector3i local_chunk_position);
+
+    /**
+     * @brief Queues a linearized octree to be written in the background.
+     */
+    void save_chunk(vector3i local_chunk_position, std::vector<uint8_t> linear_octree);
+
+    /**
+     * @brief Blocks until all queued chunks have been written.
+     */
+    void flush();
+
+private:
+    bool remap();
+
+    void run_writer();
+
+    void write_chunk(uint32_t chunk_idx, const std::vector<uint8_t>& linear_octree);
+
+    void compact();
+};
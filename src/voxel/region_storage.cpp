@@ -0,0 +1,112 @@
+#include "voxel/region_storage.hpp"
+
+#include <filesystem>
+
+#include <simple-logger.hpp>
+
+static vector3i get_region_position(vector3i chunk_position)
+{
+    // REGION_SIZE is a power of two, so shifting rounds towards negative infinity.
+    return vector3i { chunk_position.x >> 5, chunk_position.y >> 5, chunk_position.z >> 5 };
+}
+
+static vector3i get_local_chunk_position(vector3i chunk_position)
+{
+    return vector3i {
+        chunk_position.x & (REGION_SIZE - 1),
+        chunk_position.y & (REGION_SIZE - 1),
+        chunk_position.z & (REGION_SIZE - 1)
+    };
+}
+
+std::unique_ptr<RegionStorage> RegionStorage::create(const std::string& directory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    if (error)
+    {
+        sl::log_error("Failed to create the region directory `{}`.", directory);
+        return nullptr;
+    }
+
+    auto out = std::make_unique<RegionStorage>();
+
+    out->directory = directory;
+
+    return out;
+}
+
+std::optional<VoxelOctree> RegionStorage::load_chunk(vector3i chunk_position)
+{
+    RegionFile* region = get_region(get_region_position(chunk_position), false);
+
+    if (region == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    auto chunk = region->get_chunk(get_local_chunk_position(chunk_position));
+
+    if (!chunk.has_value())
+    {
+        return std::nullopt;
+    }
+
+    return VoxelOctree::create_mapped(chunk->view, std::move(chunk->mapping));
+}
+
+bool RegionStorage::save_chunk(vector3i chunk_position, const VoxelOctree& octree)
+{
+    RegionFile* region = get_region(get_region_position(chunk_position), true);
+
+    if (region == nullptr)
+    {
+        return false;
+    }
+
+    region->save_chunk(get_local_chunk_position(chunk_position), octree.linearize());
+
+    return true;
+}
+
+void RegionStorage::flush()
+{
+    std::lock_guard lock(mutex);
+
+    for (auto& [region_position, region] : regions)
+    {
+        region->flush();
+    }
+}
+
+RegionFile* RegionStorage::get_region(vector3i region_position, bool create)
+{
+    std::lock_guard lock(mutex);
+
+    auto it = regions.find(region_position);
+
+    if (it != regions.end())
+    {
+        return it->second.get();
+    }
+
+    std::string path = directory + "/r." +
+        std::to_string(region_position.x) + "." +
+        std::to_string(region_position.y) + "." +
+        std::to_string(region_position.z) + ".region";
+
+    if (!create && !std::filesystem::exists(path))
+    {
+        return nullptr;
+    }
+
+    auto region = RegionFile::open(path);
+
+    if (region == nullptr)
+    {
+        return nullptr;
+    }
+
+    return regions.emplace(region_position, std::move(region)).first->second.get();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "voxel/region_file.hpp"
+
+/**
+ * @brief Persists the chunks of a grid in a directory of \ref RegionFile.
+ *
+ * Region files are opened lazily and kept open. Chunks loaded from them keep their mappings alive on their own.
+ * Safe to use from multiple threads.
+ */
+struct RegionStorage
+{
+    std::string directory;
+
+    // Guards `regions`.
+    std::mutex mutex;
+
+    std::unordered_map<vector3i, std::unique_ptr<RegionFile>> regions;
+
+    RegionStorage() = default;
+
+    RegionStorage(const RegionStorage&) = delete; // Prevent copies.
+
+    RegionStorage& operator = (const RegionStorage&) = delete; // Prevent copies.
+
+    /**
+     * @brief Creates a storage in a directory, creating the directory if it doesn't exist.
+     */
+    static std::unique_ptr<RegionStorage> create(const std::string& directory);
+
+    /**
+     * @brief Loads a stored chunk. The returned octree reads straight from the region file until it is edited.
+     *
+     * @return std::nullopt if the chunk was never saved.
+     */
+    std::optional<VoxelOctree> load_chunk(vector3i chunk_position);
+
+    /**
+     * @brief Queues a chunk to be saved in the background.
+     */
+    bool save_chunk(vector3i chunk_position, const VoxelOctree& octree);
+
+    /**
+     * @brief Blocks until all queued chunks have been written.
+     */
+    void flush();
+
+private:
+    /**
+     * @param create Whether to create the region file if it doesn't exist yet.
+     */
+    RegionFile* get_region(vector3i region_position, bool create);
+};
@@ -4,7 +4,17 @@
 
 #include "math/vector4.hpp"
 
+enum VoxelFlags : uint32_t
+{
+    VOXEL_FLAG_NONE         = 0,
+    VOXEL_FLAG_OPAQUE       = 1 << 0,
+    VOXEL_FLAG_TRANSLUCENT  = 1 << 1,
+    VOXEL_FLAG_EMISSIVE     = 1 << 2
+};
+
 struct Voxel
 {
     vector4f color;
+    float emissive = 0.0f;
+    uint32_t flags = VOXEL_FLAG_OPAQUE;
 };
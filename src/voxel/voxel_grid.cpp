@@ -1,39 +1,231 @@
 #include "voxel/voxel_grid.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include "math/aabb.hpp"
+
+// Small enough that a ray never moves noticeably along an axis it is parallel to, large enough that its inverse is
+// finite.
+static constexpr float PARALLEL_DIRECTION_EPSILON = 1e-20f;
+
 std::optional<VoxelGrid> VoxelGrid::create(uint16_t octree_depth, float leaf_size)
 {
+    // Chunks are created on demand, so their depth is checked up front.
+    if (octree_depth < 2 || octree_depth > VoxelOctree::MAX_DEPTH)
+    {
+        return std::nullopt;
+    }
+
     VoxelGrid out;
 
     out.octree_depth = octree_depth;
     out.leaf_size = leaf_size;
 
-    out.octrees = *FreeList<VoxelOctree>::create();
-
     return out;
 }
 
-void VoxelGrid::set_voxel(vector3i position, uint32_t voxel_index)
+bool VoxelGrid::set_voxel(vector3i position, uint32_t voxel_index)
 {
-    vector3i octree_position = position / (1 << octree_depth);
-    vector3i inter_octree_position = position % (1 << octree_depth);
+    vector3i octree_position = get_chunk_position(position);
+
+    int32_t inner_mask = (1 << octree_depth) - 1;
+    vector3i inter_octree_position = { position.x & inner_mask, position.y & inner_mask, position.z & inner_mask };
 
     // Interleave position.
     uint64_t ipos = VoxelOctree::interleave_octree_coordinate(inter_octree_position);
 
-    // Get octree.
     // Find octree.
-    for (auto& octree_coordinate : octree_coordinates)
+    auto octree = get_octree(octree_position);
+
+    if (octree.has_value())
+    {
+        return (*octree)->set_voxel(ipos, voxel_index);
+    }
+
+    // Create octree.
+    auto new_octree = VoxelOctree::create(octree_depth);
+
+    if (!new_octree.has_value())
+    {
+        return false;
+    }
+
+    insert_octree(octree_position, std::move(*new_octree));
+
+    return (*get_octree(octree_position))->set_voxel(ipos, voxel_index);
+}
+
+std::optional<VoxelRaycastHit> VoxelGrid::raycast(vector3f origin, vector3f direction, float max_distance) const
+{
+    if (length_squared(direction) == 0.0f)
+    {
+        return std::nullopt;
+    }
+
+    direction = normalize(direction);
+
+    // Nudge directions parallel to an axis, so rays along voxel faces count as inside the voxels above them like they
+    // do for chunks, rather than getting NaN in the slab tests.
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] == 0.0f) direction[axis] = PARALLEL_DIRECTION_EPSILON;
+    }
+
+    Ray ray = Ray::create(origin, direction);
+
+    if (octree_coordinates.empty())
+    {
+        return std::nullopt;
+    }
+
+    int32_t chunk_size = 1 << octree_depth;
+    float chunk_extent = static_cast<float>(chunk_size);
+
+    // Only step through the chunks within the bounds of the loaded ones, so rays into unloaded space end right away.
+    vector3i min_chunk = octree_coordinates.begin()->first;
+    vector3i max_chunk = min_chunk;
+
+    for (const auto& [chunk_position, octree_handle] : octree_coordinates)
+    {
+        min_chunk = min(min_chunk, chunk_position);
+        max_chunk = max(max_chunk, chunk_position);
+    }
+
+    AABB bounds;
+
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        bounds.min[axis] = static_cast<float>(min_chunk[axis]) * chunk_extent;
+        bounds.max[axis] = static_cast<float>(max_chunk[axis] + 1) * chunk_extent;
+    }
+
+    auto interval = ray_intersect_aabb(ray, bounds, max_distance);
+
+    if (!interval.has_value())
+    {
+        return std::nullopt;
+    }
+
+    vector3f enter_position = ray.at(interval->enter);
+
+    // Step through the chunks along the ray by Amanatides and Woo's algorithm. `t_next` holds the distance to the
+    // next chunk boundary along each axis, and `t_delta` the distance between boundaries.
+    vector3i chunk;
+    vector3i step;
+    vector3f t_next;
+    vector3f t_delta;
+
+    for (size_t axis = 0; axis < 3; axis++)
     {
-        if (octree_coordinate.first == octree_position)
+        // Clamped, as rounding may put the point where the ray enters the bounds just outside them.
+        chunk[axis] = static_cast<int32_t>(std::floor(enter_position[axis] / chunk_extent));
+        chunk[axis] = std::clamp(chunk[axis], min_chunk[axis], max_chunk[axis]);
+        step[axis] = ray.direction[axis] > 0.0f ? 1 : -1;
+
+        float boundary = static_cast<float>(chunk[axis] + (step[axis] > 0 ? 1 : 0)) * chunk_extent;
+        t_next[axis] = (boundary - origin[axis]) * ray.inverse_direction[axis];
+        t_delta[axis] = chunk_extent * std::abs(ray.inverse_direction[axis]);
+    }
+
+    float t_chunk_enter = interval->enter;
+
+    while (t_chunk_enter <= interval->exit)
+    {
+        auto it = octree_coordinates.find(chunk);
+
+        if (it != octree_coordinates.end())
         {
-            (*octrees.get(octree_coordinate.second))->set_voxel(ipos, voxel_index);
-            return;
+            vector3i chunk_origin = chunk_size * chunk;
+
+            // Trace in the space of the octree, which keeps distances the same.
+            Ray local_ray = ray;
+            local_ray.origin -= vector3f {
+                static_cast<float>(chunk_origin.x),
+                static_cast<float>(chunk_origin.y),
+                static_cast<float>(chunk_origin.z)
+            };
+
+            auto hit = (*octrees.get(it->second))->get_view().raycast(local_ray, max_distance);
+
+            if (hit.has_value())
+            {
+                hit->position += chunk_origin;
+                return hit;
+            }
         }
+
+        size_t axis = t_next.x < t_next.y ? (t_next.x < t_next.z ? 0 : 2) : (t_next.y < t_next.z ? 1 : 2);
+
+        chunk[axis] += step[axis];
+        t_chunk_enter = t_next[axis];
+        t_next[axis] += t_delta[axis];
     }
 
-    // Create octree.
-    uint32_t new_octree_idx = octrees.insert(*VoxelOctree::create(octree_depth));
-    octree_coordinates.push_back({position, new_octree_idx});
+    return std::nullopt;
+}
+
+vector3i VoxelGrid::get_chunk_position(vector3i position) const
+{
+    // Arithmetic shifts round towards negative infinity, unlike division.
+    return vector3i { position.x >> octree_depth, position.y >> octree_depth, position.z >> octree_depth };
+}
+
+std::optional<VoxelOctree*> VoxelGrid::get_octree(vector3i chunk_position)
+{
+    auto it = octree_coordinates.find(chunk_position);
+
+    if (it == octree_coordinates.end())
+    {
+        return std::nullopt;
+    }
+
+    return octrees.get(it->second);
+}
 
-    (*octrees.get(new_octree_idx))->set_voxel(ipos, voxel_index);
+void VoxelGrid::insert_octree(vector3i chunk_position, VoxelOctree&& octree)
+{
+    auto it = octree_coordinates.find(chunk_position);
+
+    if (it != octree_coordinates.end())
+    {
+        **octrees.get(it->second) = std::move(octree);
+        return;
+    }
+
+    octree_coordinates[chunk_position] = octrees.insert(std::move(octree));
+}
+
+void VoxelGrid::remove_octree(vector3i chunk_position)
+{
+    auto it = octree_coordinates.find(chunk_position);
+
+    if (it == octree_coordinates.end())
+    {
+        return;
+    }
+
+    octrees.remove(it->second);
+    octree_coordinates.erase(it);
+}
+
+void VoxelGrid::compact_step(uint32_t node_budget)
+{
+    // Visit every octree at most once per call.
+    for (uint64_t i = 0; i < octrees.size() && node_budget > 0; i++)
+    {
+        if (compaction_cursor >= octrees.size())
+        {
+            compaction_cursor = 0;
+        }
+
+        VoxelOctree& octree = octrees.values[compaction_cursor];
+
+        node_budget -= octree.compact_step(node_budget);
+
+        // Ran out of budget, continue with this octree next time.
+        if (octree.compaction) return;
+
+        compaction_cursor++;
+    }
 }
@@ -1,14 +1,17 @@
 #pragma once
 
-#include <vector>
+#include <unordered_map>
 #include <utility>
 
+#include "container/slot_map.hpp"
 #include "voxel/voxel_octree.hpp"
 
 struct VoxelGrid
 {
-    FreeList<VoxelOctree> octrees;
-    std::vector<std::pair<vector3i, uint32_t>> octree_coordinates;
+    SlotMap<VoxelOctree> octrees;
+
+    // Maps chunk positions to handles into `octrees`.
+    std::unordered_map<vector3i, SlotMapHandle> octree_coordinates;
 
     vector3f position;
     vector3f rotation;
@@ -16,9 +19,46 @@ struct VoxelGrid
     uint16_t octree_depth;
     float leaf_size;
 
+    // The dense index into `octrees` at which compaction continues.
+    uint64_t compaction_cursor = 0;
+
     VoxelGrid() = default;
 
     static std::optional<VoxelGrid> create(uint16_t octree_depth, float leaf_size);
 
-    void set_voxel(vector3i position, uint32_t voxel_index);
+    /**
+     * @brief Sets a voxel, creating its chunk if it is not loaded.
+     *
+     * @return false if the chunk could not be created or ran out of storage.
+     */
+    bool set_voxel(vector3i position, uint32_t voxel_index);
+
+    /**
+     * @brief Finds the first voxel along a ray, e.g. to pick the voxel under the cursor.
+     *
+     * Works in voxel positions like \ref set_voxel, ignoring the position and rotation of the grid. Steps through the
+     * chunks along the ray, skipping those not loaded, and descends the octree of every loaded one.
+     *
+     * @param max_distance The distance along the normalized direction after which to stop.
+     */
+    std::optional<VoxelRaycastHit> raycast(vector3f origin, vector3f direction, float max_distance) const;
+
+    /**
+     * @brief Returns the position of the chunk containing a voxel position. Rounds towards negative infinity.
+     */
+    vector3i get_chunk_position(vector3i position) const;
+
+    std::optional<VoxelOctree*> get_octree(vector3i chunk_position);
+
+    /**
+     * @brief Inserts an octree at a chunk position, replacing the octree already present.
+     */
+    void insert_octree(vector3i chunk_position, VoxelOctree&& octree);
+
+    void remove_octree(vector3i chunk_position);
+
+    /**
+     * @brief Compacts the octrees that need it in turn, copying at most `node_budget` nodes. Call once per frame.
+     */
+    void compact_step(uint32_t node_budget);
 };
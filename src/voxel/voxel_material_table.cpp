@@ -0,0 +1,47 @@
+#include "voxel/voxel_material_table.hpp"
+
+#include <algorithm>
+
+VoxelMaterialTable VoxelMaterialTable::create(std::span<const Voxel> voxels)
+{
+    VoxelMaterialTable out;
+
+    out.colors.resize(voxels.size());
+    out.emissive.resize(voxels.size());
+    out.flags.resize(voxels.size());
+
+    for (uint32_t i = 0; i < voxels.size(); i++)
+    {
+        out.colors[i] = voxels[i].color;
+        out.emissive[i] = voxels[i].emissive;
+        out.flags[i] = voxels[i].flags;
+    }
+
+    // Everything has yet to be uploaded.
+    out.mark_dirty(0, voxels.size());
+
+    return out;
+}
+
+void VoxelMaterialTable::set_material(uint32_t voxel_idx, const Voxel& voxel)
+{
+    colors[voxel_idx] = voxel.color;
+    emissive[voxel_idx] = voxel.emissive;
+    flags[voxel_idx] = voxel.flags;
+
+    mark_dirty(voxel_idx, voxel_idx + 1);
+}
+
+void VoxelMaterialTable::mark_dirty(uint32_t begin, uint32_t end)
+{
+    if (!is_dirty())
+    {
+        dirty_begin = begin;
+        dirty_end = end;
+
+        return;
+    }
+
+    dirty_begin = std::min(dirty_begin, begin);
+    dirty_end = std::max(dirty_end, end);
+}
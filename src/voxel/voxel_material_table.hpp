@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "voxel/voxel.hpp"
+
+/**
+ * @brief A structure-of-arrays copy of the registered voxels, laid out the way the voxel shader reads them.
+ *
+ * Every array is std430 compatible on its own, so each one can be copied into a storage buffer without conversion.
+ * Changes are tracked as a single dirty range of voxel indices, which the renderer consumes when uploading.
+ */
+struct VoxelMaterialTable
+{
+    std::vector<vector4f> colors;
+    std::vector<float> emissive;
+    std::vector<uint32_t> flags;
+
+    // Range [dirty_begin, dirty_end) of voxel indices that changed since the last upload.
+    uint32_t dirty_begin = 0;
+    uint32_t dirty_end = 0;
+
+    static VoxelMaterialTable create(std::span<const Voxel> voxels);
+
+    uint32_t get_material_count() const { return colors.size(); }
+
+    void set_material(uint32_t voxel_idx, const Voxel& voxel);
+
+    bool is_dirty() const { return dirty_begin < dirty_end; }
+
+    void mark_dirty(uint32_t begin, uint32_t end);
+
+    void clear_dirty() { dirty_begin = dirty_end = 0; }
+};
@@ -1,5 +1,23 @@
 #include "voxel/voxel_octree.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+
+#include <simple-logger.hpp>
+
+#include "container/linear_arena.hpp"
+#include "math/aabb.hpp"
+
+// The most address space reserved for the bricks of an octree. Only the pages in use are committed.
+static constexpr uint64_t BRICK_STORAGE_RESERVE_SIZE = 64ull * 1024 * 1024;
+
+// The amount of edits after which an octree is compacted.
+static constexpr uint32_t COMPACTION_EDIT_THRESHOLD = 256;
+
 static constexpr uint64_t B[] =
 {
     0x9249'2492'4924'9249, 0x30C3'0C30'C30C'30C3, 0xF00F'00F0'0F00'F00F,
@@ -8,24 +26,115 @@ static constexpr uint64_t B[] =
 
 static constexpr uint64_t S[] = {2, 4, 8, 16, 32};
 
+// The corners of the children of a node along each axis, in units of the child size. Indexed like branches.
+static constexpr float CHILD_OFFSETS[3][8] =
+{
+    {0, 1, 0, 1, 0, 1, 0, 1},
+    {0, 0, 1, 1, 0, 0, 1, 1},
+    {0, 0, 0, 0, 1, 1, 1, 1}
+};
+
+// A node, voxel octant or brick a ray passes through and that is still to be visited.
+struct RaycastEntry
+{
+    VoxelOctreeNodeMask mask;
+    uint32_t branch;
+    vector3i position;
+    int32_t size;
+    float t_enter;
+};
+
+static uint64_t align_linear_offset(uint64_t offset);
+
+// Reserves storage for the bricks of an octree, large enough for a distinct 32-bit voxel in every leaf.
+static std::unique_ptr<GrowableBufferResource> create_brick_storage(uint8_t depth);
+
+// Returns the amount of nodes an octree of a depth can hold, to reserve address space for its nodes.
+static uint64_t get_max_node_count(uint8_t depth);
+
+static vector3i get_child_offset(uint32_t branch_idx);
+
+// Intersects a ray with the children of a node, returning the children hit and filling `t_enter` for each.
+static uint8_t ray_intersect_children(
+    const Ray& ray,
+    vector3i position,
+    int32_t child_size,
+    float t_max,
+    float* t_enter
+);
+
+// Whether a ray starting on the boundary of a box leaves it right away, so it only touches it at distance 0.
+static bool ray_leaves_at_origin(const Ray& ray, vector3i position, int32_t size);
+
+static VoxelRaycastHit create_raycast_hit(
+    const Ray& ray,
+    vector3i position,
+    int32_t size,
+    float t_enter,
+    uint32_t voxel_index
+);
+
+// Copies the nodes and bricks reachable from a node in depth-first order, so that every index is dense. `level` is the
+// level of the branches of the node, counting down to 1 for the level holding bricks, which bounds the recursion.
+static uint32_t copy_depth_first(
+    const VoxelOctreeView& view,
+    uint32_t node_idx,
+    int32_t level,
+    std::pmr::vector<VoxelOctreeNode>& out_nodes,
+    PackedArray& out_bricks
+);
+
+// Checks that every index of a linearized octree is in bounds, and that its nodes form a tree in depth-first order
+// that is no deeper than the octree, as written by \ref VoxelOctree::linearize.
+static bool validate_linear_octree(const VoxelOctreeView& view);
+
 void VoxelOctreeNode::set_branch_mask(uint32_t branch_idx, uint16_t mask)
 {
     masks = masks & ~(((uint16_t) 0b11) << (branch_idx * 2));
     masks = masks | (mask << branch_idx * 2);
 }
 
-uint16_t VoxelOctreeNode::get_branch_mask(uint32_t branch_idx)
+uint16_t VoxelOctreeNode::get_branch_mask(uint32_t branch_idx) const
 {
     return (masks >> (branch_idx * 2)) & 0b11;
 }
 
+VoxelOctree::VoxelOctree(std::unique_ptr<GrowableBufferResource> brick_storage)
+    : brick_storage {std::move(brick_storage)}, bricks {1, this->brick_storage.get()}
+{
+}
+
+VoxelOctree& VoxelOctree::operator = (VoxelOctree&& other)
+{
+    if (this == &other) return *this;
+
+    // The containers must be destroyed before the storage they allocate from, and must take over the allocations of
+    // `other` instead of copying them, which rebuilding the octree in place takes care of.
+    std::destroy_at(this);
+    std::construct_at(this, std::move(other));
+
+    return *this;
+}
+
 std::optional<VoxelOctree> VoxelOctree::create(uint8_t depth)
 {
-    VoxelOctree out;
+    if (depth < 2 || depth > MAX_DEPTH)
+    {
+        return std::nullopt;
+    }
 
-    out.depth = depth;
+    auto brick_storage = create_brick_storage(depth);
+    auto nodes = FreeList<VoxelOctreeNode>::create(4, get_max_node_count(depth));
 
-    out.nodes = *std::move(FreeList<VoxelOctreeNode>::create());
+    if (!brick_storage || !nodes.has_value())
+    {
+        return std::nullopt;
+    }
+
+    VoxelOctree out(std::move(brick_storage));
+
+    out.depth = depth;
+    out.nodes = std::move(*nodes);
 
     VoxelOctreeNode root_node {};
 
@@ -34,6 +143,62 @@ std::optional<VoxelOctree> VoxelOctree::create(uint8_t depth)
     return out;
 }
 
+VoxelOctree VoxelOctree::create_mapped(VoxelOctreeView view, std::shared_ptr<const void> owner)
+{
+    VoxelOctree out;
+
+    out.depth = view.depth;
+    out.mapped = view;
+    out.mapped_owner = std::move(owner);
+
+    return out;
+}
+
+std::optional<VoxelOctree> VoxelOctree::create_from_view(const VoxelOctreeView& view)
+{
+    auto brick_storage = create_brick_storage(view.depth);
+
+    if (!brick_storage)
+    {
+        return std::nullopt;
+    }
+
+    VoxelOctree out(std::move(brick_storage));
+
+    out.depth = view.depth;
+
+    // The nodes are gathered in scratch memory, as their final amount is not known up front.
+    LinearArenaScope scratch_scope(LinearArena::get_thread_scratch());
+
+    std::pmr::vector<VoxelOctreeNode> dense_nodes(&scratch_scope.arena);
+    PackedArray dense_bricks(view.brick_width, out.brick_storage.get());
+
+    copy_depth_first(view, 0, view.depth - 1, dense_nodes, dense_bricks);
+
+    auto nodes = FreeList<VoxelOctreeNode>::create(
+        dense_nodes.size(),
+        std::max<uint64_t>(dense_nodes.size(), get_max_node_count(view.depth))
+    );
+
+    if (!nodes.has_value())
+    {
+        return std::nullopt;
+    }
+
+    out.nodes = std::move(*nodes);
+
+    // Inserting into an empty list hands out consecutive indices, so the branch indices stay valid.
+    for (auto& node : dense_nodes)
+    {
+        out.nodes.insert(node);
+    }
+
+    out.palette.global_indices.assign(view.palette.begin(), view.palette.end());
+    out.bricks = std::move(dense_bricks);
+
+    return out;
+}
+
 uint64_t VoxelOctree::interleave_octree_coordinate(vector3i pos)
 {
     return interleave_octree_coordinate(pos.x, pos.y, pos.z);
@@ -62,14 +227,60 @@ uint64_t VoxelOctree::interleave_octree_coordinate(uint64_t x, uint64_t y, uint6
     return (x) | (y << 1) | (z << 2);
 }
 
-void VoxelOctree::set_voxel(uint64_t ipos, uint32_t voxel_idx)
+bool VoxelOctree::set_voxel(uint64_t ipos, uint32_t voxel_idx)
+{
+    // Copy mapped data before the first edit.
+    if (mapped.has_value())
+    {
+        auto copy = create_from_view(*mapped);
+
+        if (!copy.has_value())
+        {
+            sl::log_error("Failed to copy a mapped octree before editing it.");
+            return false;
+        }
+
+        *this = std::move(*copy);
+    }
+
+    // A compaction in progress copied the octree as it was, so it has to start over.
+    compaction.reset();
+    edits_since_compaction++;
+
+    // The node and brick storage throw once the octree outgrows its reservation. Every allocation happens before the
+    // step that links it in, so a failure leaves the octree valid.
+    try
+    {
+        set_local_voxel(ipos, palette.get_or_insert_local_index(voxel_idx));
+    }
+    catch (const std::bad_alloc&)
+    {
+        sl::log_error("Ran out of storage for the nodes or bricks of an octree of depth {}.",
+            static_cast<uint32_t>(depth));
+        return false;
+    }
+
+    return true;
+}
+
+void VoxelOctree::set_local_voxel(uint64_t ipos, uint32_t local_voxel_idx)
 {
-    // Get the root node.
-    VoxelOctreeNode* current_node = *nodes.get(0);
+    // Widen the bricks if the palette outgrew them.
+    uint8_t required_width = palette.get_required_width();
 
-    // Step through octree.
-    for (int32_t i = depth - 1; i >= 0; i--)
+    if (required_width > bricks.width)
     {
+        bricks.set_width(required_width);
+    }
+
+    // Start at the root node. Nodes are tracked by index, as inserting a new node may move the node storage.
+    uint32_t current_node_idx = 0;
+
+    // Step through octree. The last step (i == 0) happens inside of a brick.
+    for (int32_t i = depth - 1; i >= 1; i--)
+    {
+        VoxelOctreeNode* current_node = *nodes.get(current_node_idx);
+
         uint64_t branch_index = (ipos >> (i * 3)) & 0b111;
 
         // Check branch state.
@@ -77,11 +288,16 @@ void VoxelOctree::set_voxel(uint64_t ipos, uint32_t voxel_idx)
         {
         case VoxelOctreeNodeMask::ABSENT_OCTANT:
         {
-            if (i == 0)
+            if (i == 1)
             {
-                // Set leaf.
-                current_node->branches[branch_index] = voxel_idx;
-                current_node->set_branch_mask(branch_index, (uint16_t) VoxelOctreeNodeMask::VOXEL);
+                // Create brick and set leaf.
+                uint32_t brick_idx = allocate_brick(VoxelPalette::EMPTY_LOCAL_INDEX);
+
+                bricks.set(brick_idx * 8 + (ipos & 0b111), local_voxel_idx);
+
+                current_node = *nodes.get(current_node_idx);
+                current_node->branches[branch_index] = brick_idx;
+                current_node->set_branch_mask(branch_index, (uint16_t) VoxelOctreeNodeMask::BRICK);
             }
             else
             {
@@ -90,47 +306,64 @@ void VoxelOctree::set_voxel(uint64_t ipos, uint32_t voxel_idx)
 
                 uint32_t node_idx = nodes.insert(new_node);
 
+                current_node = *nodes.get(current_node_idx);
                 current_node->branches[branch_index] = node_idx;
                 current_node->set_branch_mask(branch_index, (uint16_t) VoxelOctreeNodeMask::OCTANT);
 
-                current_node = *nodes.get(node_idx);
+                current_node_idx = node_idx;
             }
         } break;
         case VoxelOctreeNodeMask::OCTANT:
         {
-            current_node = *nodes.get(current_node->branches[branch_index]);
-
+            current_node_idx = current_node->branches[branch_index];
         } break;
         case VoxelOctreeNodeMask::VOXEL_OCTANT:
         {
             // Split voxel octant to create room for to be added voxel.
 
             // Check if voxel octant already consists of to be added voxel.
-            if (current_node->branches[branch_index] == voxel_idx)
+            uint32_t octant_voxel_idx = current_node->branches[branch_index];
+
+            if (octant_voxel_idx == local_voxel_idx)
             {
                 // Nothing to be done.
                 return;
             }
 
+            if (i == 1)
+            {
+                // Split into a brick filled with the octant voxel.
+                uint32_t brick_idx = allocate_brick(octant_voxel_idx);
+
+                bricks.set(brick_idx * 8 + (ipos & 0b111), local_voxel_idx);
+
+                current_node = *nodes.get(current_node_idx);
+                current_node->branches[branch_index] = brick_idx;
+                current_node->set_branch_mask(branch_index, (uint16_t) VoxelOctreeNodeMask::BRICK);
+
+                break;
+            }
+
             VoxelOctreeNode new_node {};
 
             for (uint16_t j = 0; j < 8; j++)
             {
                 // Copy over voxel id.
-                new_node.branches[j] = current_node->branches[branch_index];
+                new_node.branches[j] = octant_voxel_idx;
                 new_node.set_branch_mask(j, (uint16_t) VoxelOctreeNodeMask::VOXEL_OCTANT);
             }
 
             uint32_t node_idx = nodes.insert(new_node);
 
+            current_node = *nodes.get(current_node_idx);
             current_node->branches[branch_index] = node_idx;
             current_node->set_branch_mask(branch_index, (uint16_t) VoxelOctreeNodeMask::OCTANT);
 
-            current_node = *nodes.get(node_idx);
+            current_node_idx = node_idx;
         } break;
-        case VoxelOctreeNodeMask::VOXEL:
+        case VoxelOctreeNodeMask::BRICK:
         {
-            current_node->branches[branch_index] = voxel_idx;
+            bricks.set(current_node->branches[branch_index] * 8 + (ipos & 0b111), local_voxel_idx);
         } break;
         }
     }
@@ -140,5 +373,690 @@ void VoxelOctree::set_voxel(uint64_t ipos, uint32_t voxel_idx)
 
 void VoxelOctree::compress_from_leaf(uint64_t leaf_pos)
 {
-    // TODO:
+    // Collect the nodes down to the one holding the leaf, the root first.
+    uint32_t node_path[MAX_DEPTH];
+    uint32_t path_length = 0;
+    uint32_t node_idx = 0;
+
+    for (int32_t i = depth - 1; i >= 1; i--)
+    {
+        node_path[path_length++] = node_idx;
+
+        const VoxelOctreeNode* node = *nodes.get(node_idx);
+        uint64_t branch_index = (leaf_pos >> (i * 3)) & 0b111;
+
+        if ((VoxelOctreeNodeMask) node->get_branch_mask(branch_index) != VoxelOctreeNodeMask::OCTANT) break;
+
+        node_idx = node->branches[branch_index];
+    }
+
+    // The level of the branches of the last node on the path.
+    int32_t level = depth - path_length;
+
+    VoxelOctreeNode* node = *nodes.get(node_path[path_length - 1]);
+    uint64_t branch_index = (leaf_pos >> (level * 3)) & 0b111;
+
+    if ((VoxelOctreeNodeMask) node->get_branch_mask(branch_index) != VoxelOctreeNodeMask::BRICK) return;
+
+    // Replace a brick holding a single voxel with a voxel octant, or drop it if it is empty.
+    uint32_t brick_idx = node->branches[branch_index];
+    uint32_t local_voxel_idx = bricks.get(brick_idx * 8);
+
+    for (uint32_t i = 1; i < 8; i++)
+    {
+        if (bricks.get(brick_idx * 8 + i) != local_voxel_idx) return;
+    }
+
+    VoxelOctreeNodeMask mask = local_voxel_idx == VoxelPalette::EMPTY_LOCAL_INDEX
+        ? VoxelOctreeNodeMask::ABSENT_OCTANT
+        : VoxelOctreeNodeMask::VOXEL_OCTANT;
+
+    node->branches[branch_index] = local_voxel_idx;
+    node->set_branch_mask(branch_index, (uint16_t) mask);
+
+    free_bricks.push_back(brick_idx);
+
+    // Merge every node whose branches became all absent, or all the same voxel octant, into its parent. The root stays.
+    for (uint32_t i = path_length - 1; i >= 1; i--)
+    {
+        node = *nodes.get(node_path[i]);
+
+        bool is_absent = node->masks == 0;
+        bool is_voxel_octant = node->masks == 0xAAAA &&
+            std::all_of(node->branches, node->branches + 8, [node](uint32_t b) { return b == node->branches[0]; });
+
+        if (!is_absent && !is_voxel_octant) return;
+
+        local_voxel_idx = is_absent ? VoxelPalette::EMPTY_LOCAL_INDEX : node->branches[0];
+        mask = is_absent ? VoxelOctreeNodeMask::ABSENT_OCTANT : VoxelOctreeNodeMask::VOXEL_OCTANT;
+
+        nodes.free(node_path[i]);
+
+        VoxelOctreeNode* parent = *nodes.get(node_path[i - 1]);
+        branch_index = (leaf_pos >> ((depth - i) * 3)) & 0b111;
+
+        parent->branches[branch_index] = local_voxel_idx;
+        parent->set_branch_mask(branch_index, (uint16_t) mask);
+    }
+}
+
+VoxelOctreeView VoxelOctree::get_view() const
+{
+    if (mapped.has_value())
+    {
+        return *mapped;
+    }
+
+    return VoxelOctreeView {
+        depth,
+        std::span<const VoxelOctreeNode>(nodes.data, nodes.capacity),
+        palette.global_indices,
+        bricks.words,
+        bricks.width,
+        get_brick_count()
+    };
+}
+
+std::vector<uint8_t> VoxelOctree::linearize() const
+{
+    VoxelOctreeView view = get_view();
+
+    LinearArenaScope scratch_scope(LinearArena::get_thread_scratch());
+
+    std::pmr::vector<VoxelOctreeNode> dense_nodes(&scratch_scope.arena);
+    PackedArray dense_bricks(view.brick_width, &scratch_scope.arena);
+
+    copy_depth_first(view, 0, view.depth - 1, dense_nodes, dense_bricks);
+
+    LinearVoxelOctreeHeader header {};
+    header.magic = LinearVoxelOctreeHeader::MAGIC;
+    header.depth = view.depth;
+    header.brick_width = view.brick_width;
+    header.node_count = dense_nodes.size();
+    header.palette_size = view.palette.size();
+    header.brick_count = dense_bricks.size / 8;
+
+    uint64_t nodes_offset = align_linear_offset(sizeof(LinearVoxelOctreeHeader));
+    uint64_t palette_offset = align_linear_offset(nodes_offset + dense_nodes.size() * sizeof(VoxelOctreeNode));
+    uint64_t bricks_offset = align_linear_offset(palette_offset + view.palette.size_bytes());
+
+    std::vector<uint8_t> out(bricks_offset + dense_bricks.get_byte_size(), 0);
+
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + nodes_offset, dense_nodes.data(), dense_nodes.size() * sizeof(VoxelOctreeNode));
+    std::copy(view.palette.begin(), view.palette.end(), reinterpret_cast<uint32_t*>(out.data() + palette_offset));
+    std::copy(
+        dense_bricks.words.begin(),
+        dense_bricks.words.end(),
+        reinterpret_cast<uint64_t*>(out.data() + bricks_offset)
+    );
+
+    return out;
+}
+
+bool VoxelOctree::needs_compaction() const
+{
+    if (mapped.has_value())
+    {
+        // Mapped octrees are stored in depth-first order.
+        return false;
+    }
+
+    return edits_since_compaction >= COMPACTION_EDIT_THRESHOLD;
+}
+
+uint32_t VoxelOctree::compact_step(uint32_t node_budget)
+{
+    if (!compaction)
+    {
+        if (!needs_compaction())
+        {
+            return 0;
+        }
+
+        auto compaction_brick_storage = create_brick_storage(depth);
+
+        // The final sizes are known up front, so nothing has to grow and the capacity shrinks to fit.
+        auto compaction_nodes = FreeList<VoxelOctreeNode>::create(
+            nodes.get_live_count(),
+            std::max(nodes.get_live_count(), get_max_node_count(depth))
+        );
+
+        if (!compaction_brick_storage || !compaction_nodes.has_value())
+        {
+            return 0;
+        }
+
+        compaction = std::make_unique<VoxelOctreeCompaction>(std::move(compaction_brick_storage), bricks.width);
+        compaction->nodes = std::move(*compaction_nodes);
+
+        compaction->bricks.words.reserve(bricks.words.size());
+
+        compaction->pending.push_back({ 0, UINT32_MAX, 0 });
+    }
+
+    uint32_t copied_node_count = 0;
+
+    while (!compaction->pending.empty() && copied_node_count < node_budget)
+    {
+        VoxelOctreeCompaction::PendingNode pending_node = compaction->pending.back();
+        compaction->pending.pop_back();
+
+        VoxelOctreeNode node = **nodes.get(pending_node.node_idx);
+
+        uint32_t new_node_idx = compaction->nodes.insert(node);
+
+        if (pending_node.parent_idx != UINT32_MAX)
+        {
+            (*compaction->nodes.get(pending_node.parent_idx))->branches[pending_node.branch_idx] = new_node_idx;
+        }
+
+        VoxelOctreeNode* new_node = *compaction->nodes.get(new_node_idx);
+
+        // Push children in reverse, so the first child is copied next.
+        for (int32_t i = 7; i >= 0; i--)
+        {
+            if ((VoxelOctreeNodeMask) node.get_branch_mask(i) == VoxelOctreeNodeMask::OCTANT)
+            {
+                compaction->pending.push_back({ node.branches[i], new_node_idx, static_cast<uint32_t>(i) });
+            }
+        }
+
+        // Bricks are copied along with their node.
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            if ((VoxelOctreeNodeMask) node.get_branch_mask(i) != VoxelOctreeNodeMask::BRICK) continue;
+
+            uint32_t new_brick_idx = compaction->bricks.size / 8;
+            compaction->bricks.resize(compaction->bricks.size + 8);
+
+            for (uint32_t j = 0; j < 8; j++)
+            {
+                compaction->bricks.set(new_brick_idx * 8 + j, bricks.get(node.branches[i] * 8 + j));
+            }
+
+            new_node->branches[i] = new_brick_idx;
+        }
+
+        copied_node_count++;
+    }
+
+    if (!compaction->pending.empty())
+    {
+        return copied_node_count;
+    }
+
+    // Swap in the compacted storage, which releases the old nodes and bricks.
+    VoxelOctree out(std::move(compaction->brick_storage));
+
+    out.depth = depth;
+    out.nodes = std::move(compaction->nodes);
+    out.bricks = std::move(compaction->bricks);
+    out.palette = std::move(palette);
+
+    *this = std::move(out);
+
+    return copied_node_count;
+}
+
+uint64_t VoxelOctree::get_memory_usage() const
+{
+    uint64_t out = FreeList<VoxelOctreeNode>::get_byte_size(nodes.capacity) +
+        FreeList<VoxelOctreeNode>::get_word_count(nodes.capacity) * sizeof(uint64_t);
+
+    out += palette.global_indices.capacity() * sizeof(uint32_t);
+    out += free_bricks.capacity() * sizeof(uint32_t);
+
+    if (brick_storage) out += brick_storage->get_committed_size();
+
+    if (compaction)
+    {
+        out += FreeList<VoxelOctreeNode>::get_byte_size(compaction->nodes.capacity) +
+            FreeList<VoxelOctreeNode>::get_word_count(compaction->nodes.capacity) * sizeof(uint64_t) +
+            compaction->brick_storage->get_committed_size();
+    }
+
+    return out;
+}
+
+uint32_t VoxelOctree::allocate_brick(uint32_t local_voxel_idx)
+{
+    uint32_t brick_idx;
+
+    // Reuse bricks that were merged away, before growing the bricks.
+    if (!free_bricks.empty())
+    {
+        brick_idx = free_bricks.back();
+        free_bricks.pop_back();
+    }
+    else
+    {
+        brick_idx = get_brick_count();
+        bricks.resize(bricks.size + 8);
+    }
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        bricks.set(brick_idx * 8 + i, local_voxel_idx);
+    }
+
+    return brick_idx;
+}
+
+std::optional<VoxelOctreeView> VoxelOctreeView::from_linear(std::span<const uint8_t> data)
+{
+    if (data.size() < sizeof(LinearVoxelOctreeHeader) || reinterpret_cast<uintptr_t>(data.data()) % 8 != 0)
+    {
+        return std::nullopt;
+    }
+
+    const auto* header = reinterpret_cast<const LinearVoxelOctreeHeader*>(data.data());
+
+    if (header->magic != LinearVoxelOctreeHeader::MAGIC || header->node_count == 0 ||
+        header->depth < 2 || header->depth > VoxelOctree::MAX_DEPTH)
+    {
+        return std::nullopt;
+    }
+
+    // Bricks are packed with a power of two width of at most 32 bits, and take at least a byte each.
+    if (!std::has_single_bit(header->brick_width) || header->brick_width > 32 || header->brick_count > data.size())
+    {
+        return std::nullopt;
+    }
+
+    uint64_t nodes_offset = align_linear_offset(sizeof(LinearVoxelOctreeHeader));
+    uint64_t palette_offset = align_linear_offset(nodes_offset + header->node_count * sizeof(VoxelOctreeNode));
+    uint64_t bricks_offset = align_linear_offset(palette_offset + header->palette_size * sizeof(uint32_t));
+    uint64_t word_count = PackedArray::get_word_count(header->brick_count * 8, header->brick_width);
+
+    if (data.size() < bricks_offset + word_count * sizeof(uint64_t))
+    {
+        return std::nullopt;
+    }
+
+    VoxelOctreeView out {
+        header->depth,
+        { reinterpret_cast<const VoxelOctreeNode*>(data.data() + nodes_offset), header->node_count },
+        { reinterpret_cast<const uint32_t*>(data.data() + palette_offset), header->palette_size },
+        { reinterpret_cast<const uint64_t*>(data.data() + bricks_offset), word_count },
+        header->brick_width,
+        header->brick_count
+    };
+
+    if (!validate_linear_octree(out))
+    {
+        return std::nullopt;
+    }
+
+    return out;
+}
+
+std::optional<uint32_t> VoxelOctreeView::get_voxel(uint64_t ipos) const
+{
+    const VoxelOctreeNode* current_node = &nodes[0];
+
+    for (int32_t i = depth - 1; i >= 1; i--)
+    {
+        uint64_t branch_index = (ipos >> (i * 3)) & 0b111;
+        uint32_t branch = current_node->branches[branch_index];
+
+        switch ((VoxelOctreeNodeMask) current_node->get_branch_mask(branch_index))
+        {
+        case VoxelOctreeNodeMask::ABSENT_OCTANT:
+            return std::nullopt;
+        case VoxelOctreeNodeMask::OCTANT:
+            current_node = &nodes[branch];
+            break;
+        case VoxelOctreeNodeMask::VOXEL_OCTANT:
+            return palette[branch - 1];
+        case VoxelOctreeNodeMask::BRICK:
+        {
+            uint32_t local_voxel_idx = get_brick_voxel(branch, ipos & 0b111);
+
+            if (local_voxel_idx == VoxelPalette::EMPTY_LOCAL_INDEX)
+            {
+                return std::nullopt;
+            }
+
+            return palette[local_voxel_idx - 1];
+        }
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<VoxelRaycastHit> VoxelOctreeView::raycast(const Ray& ray, float t_max) const
+{
+    int32_t octree_size = 1 << depth;
+    float octree_extent = static_cast<float>(octree_size);
+
+    if (!ray_intersect_aabb(ray, AABB { { 0, 0, 0 }, { octree_extent, octree_extent, octree_extent } }, t_max))
+    {
+        return std::nullopt;
+    }
+
+    uint8_t octant_mask = ray.get_octant_mask();
+
+    // Every visit replaces one entry with at most eight, nearest on top.
+    RaycastEntry stack[7 * VoxelOctree::MAX_DEPTH + 1];
+    uint32_t stack_size = 0;
+
+    stack[stack_size++] = { VoxelOctreeNodeMask::OCTANT, 0, { 0, 0, 0 }, octree_size, 0.0f };
+
+    float t_enter[8];
+
+    while (stack_size > 0)
+    {
+        RaycastEntry entry = stack[--stack_size];
+
+        switch (entry.mask)
+        {
+        case VoxelOctreeNodeMask::ABSENT_OCTANT:
+            break;
+        case VoxelOctreeNodeMask::OCTANT:
+        {
+            const VoxelOctreeNode& node = nodes[entry.branch];
+            int32_t child_size = entry.size / 2;
+
+            uint8_t hit_mask = ray_intersect_children(ray, entry.position, child_size, t_max, t_enter);
+
+            // Push back to front, so the nearest child is visited first.
+            for (int32_t i = 7; i >= 0; i--)
+            {
+                uint8_t branch_idx = ray_get_child_order(octant_mask, i);
+                auto mask = (VoxelOctreeNodeMask) node.get_branch_mask(branch_idx);
+
+                if (!(hit_mask & (1 << branch_idx)) || mask == VoxelOctreeNodeMask::ABSENT_OCTANT) continue;
+
+                vector3i child_position = entry.position + child_size * get_child_offset(branch_idx);
+
+                if (t_enter[branch_idx] == 0.0f && ray_leaves_at_origin(ray, child_position, child_size)) continue;
+
+                stack[stack_size++] = {
+                    mask,
+                    node.branches[branch_idx],
+                    child_position,
+                    child_size,
+                    t_enter[branch_idx]
+                };
+            }
+
+            break;
+        }
+        case VoxelOctreeNodeMask::VOXEL_OCTANT:
+            return create_raycast_hit(ray, entry.position, entry.size, entry.t_enter, palette[entry.branch - 1]);
+        case VoxelOctreeNodeMask::BRICK:
+        {
+            uint8_t hit_mask = ray_intersect_children(ray, entry.position, 1, t_max, t_enter);
+
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                uint8_t leaf_idx = ray_get_child_order(octant_mask, i);
+
+                if (!(hit_mask & (1 << leaf_idx))) continue;
+
+                uint32_t local_voxel_idx = get_brick_voxel(entry.branch, leaf_idx);
+
+                if (local_voxel_idx == VoxelPalette::EMPTY_LOCAL_INDEX) continue;
+
+                vector3i leaf_position = entry.position + get_child_offset(leaf_idx);
+
+                if (t_enter[leaf_idx] == 0.0f && ray_leaves_at_origin(ray, leaf_position, 1)) continue;
+
+                return create_raycast_hit(
+                    ray,
+                    leaf_position,
+                    1,
+                    t_enter[leaf_idx],
+                    palette[local_voxel_idx - 1]
+                );
+            }
+
+            break;
+        }
+        }
+    }
+
+    return std::nullopt;
+}
+
+static uint64_t align_linear_offset(uint64_t offset)
+{
+    return (offset + 7) & ~7ull;
+}
+
+static uint32_t copy_depth_first(
+    const VoxelOctreeView& view,
+    uint32_t node_idx,
+    int32_t level,
+    std::pmr::vector<VoxelOctreeNode>& out_nodes,
+    PackedArray& out_bricks
+)
+{
+    uint32_t out_node_idx = out_nodes.size();
+    out_nodes.push_back(view.nodes[node_idx]);
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        uint32_t branch = view.nodes[node_idx].branches[i];
+
+        switch ((VoxelOctreeNodeMask) view.nodes[node_idx].get_branch_mask(i))
+        {
+        case VoxelOctreeNodeMask::OCTANT:
+        {
+            if (level <= 1) break;
+
+            uint32_t child_idx = copy_depth_first(view, branch, level - 1, out_nodes, out_bricks);
+
+            out_nodes[out_node_idx].branches[i] = child_idx;
+        } break;
+        case VoxelOctreeNodeMask::BRICK:
+        {
+            uint32_t brick_idx = out_bricks.size / 8;
+            out_bricks.resize(out_bricks.size + 8);
+
+            for (uint32_t j = 0; j < 8; j++)
+            {
+                out_bricks.set(brick_idx * 8 + j, view.get_brick_voxel(branch, j));
+            }
+
+            out_nodes[out_node_idx].branches[i] = brick_idx;
+        } break;
+        default:
+            break;
+        }
+    }
+
+    return out_node_idx;
+}
+
+static vector3i get_child_offset(uint32_t branch_idx)
+{
+    return vector3i {
+        static_cast<int32_t>(branch_idx & 1),
+        static_cast<int32_t>((branch_idx >> 1) & 1),
+        static_cast<int32_t>((branch_idx >> 2) & 1)
+    };
+}
+
+static uint8_t ray_intersect_children(
+    const Ray& ray,
+    vector3i position,
+    int32_t child_size,
+    float t_max,
+    float* t_enter
+)
+{
+    float8 size = float8::broadcast(static_cast<float>(child_size));
+
+    vector3x8 offsets = {
+        float8::load(CHILD_OFFSETS[0]),
+        float8::load(CHILD_OFFSETS[1]),
+        float8::load(CHILD_OFFSETS[2])
+    };
+
+    vector3x8 min = vector3x8::broadcast(vector3f {
+        static_cast<float>(position.x),
+        static_cast<float>(position.y),
+        static_cast<float>(position.z)
+    }) + size * offsets;
+
+    AABBx8 children = { min, min + vector3x8 { size, size, size } };
+
+    float8 t_enter8;
+    uint8_t hit_mask = ray_intersect_aabb(ray, children, t_max, t_enter8);
+
+    t_enter8.store(t_enter);
+
+    return hit_mask;
+}
+
+static bool ray_leaves_at_origin(const Ray& ray, vector3i position, int32_t size)
+{
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        float low = static_cast<float>(position[axis]);
+        float high = static_cast<float>(position[axis] + size);
+
+        if ((ray.origin[axis] == high && ray.direction[axis] > 0.0f) ||
+            (ray.origin[axis] == low && ray.direction[axis] < 0.0f))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static VoxelRaycastHit create_raycast_hit(
+    const Ray& ray,
+    vector3i position,
+    int32_t size,
+    float t_enter,
+    uint32_t voxel_index
+)
+{
+    VoxelRaycastHit out = { position, voxel_index, { 0, 0, 0 }, t_enter };
+
+    vector3f entry_point = ray.at(t_enter);
+
+    float entry_axis_t = -std::numeric_limits<float>::infinity();
+    size_t entry_axis = 0;
+
+    for (size_t axis = 0; axis < 3; axis++)
+    {
+        // Voxel octants span many voxels, so find the one the ray enters. On a voxel boundary, that is the voxel below
+        // it for a ray going down. Clamped against rounding at the faces.
+        float voxel_coordinate = ray.direction[axis] < 0.0f
+            ? std::ceil(entry_point[axis]) - 1.0f
+            : std::floor(entry_point[axis]);
+
+        int32_t voxel = static_cast<int32_t>(voxel_coordinate);
+        out.position[axis] = std::clamp(voxel, position[axis], position[axis] + size - 1);
+
+        // The ray enters through the face of the slab it enters last.
+        float t0 = (static_cast<float>(position[axis]) - ray.origin[axis]) * ray.inverse_direction[axis];
+        float t1 = (static_cast<float>(position[axis] + size) - ray.origin[axis]) * ray.inverse_direction[axis];
+        float t_near = t0 < t1 ? t0 : t1;
+
+        if (t_near > entry_axis_t)
+        {
+            entry_axis_t = t_near;
+            entry_axis = axis;
+        }
+    }
+
+    // A ray starting inside the voxel enters through no face.
+    if (t_enter > 0.0f)
+    {
+        out.normal[entry_axis] = ray.direction[entry_axis] < 0.0f ? 1 : -1;
+    }
+
+    return out;
+}
+
+static bool validate_linear_octree(const VoxelOctreeView& view)
+{
+    struct PendingNode
+    {
+        uint32_t node_idx;
+        int32_t level;
+    };
+
+    // Walk the nodes in the order linearize wrote them, so every node has to be the next one in the array. That rules
+    // out shared nodes and cycles along with indices out of bounds.
+    std::vector<PendingNode> pending = { { 0, view.depth - 1 } };
+    uint32_t next_node_idx = 0;
+
+    while (!pending.empty())
+    {
+        PendingNode pending_node = pending.back();
+        pending.pop_back();
+
+        if (pending_node.node_idx != next_node_idx || pending_node.node_idx >= view.nodes.size())
+        {
+            return false;
+        }
+
+        next_node_idx++;
+
+        const VoxelOctreeNode& node = view.nodes[pending_node.node_idx];
+
+        // Push children in reverse, so the first child is visited next.
+        for (int32_t i = 7; i >= 0; i--)
+        {
+            uint32_t branch = node.branches[i];
+
+            switch ((VoxelOctreeNodeMask) node.get_branch_mask(i))
+            {
+            case VoxelOctreeNodeMask::ABSENT_OCTANT:
+                break;
+            case VoxelOctreeNodeMask::OCTANT:
+                if (pending_node.level <= 1) return false;
+
+                pending.push_back({ branch, pending_node.level - 1 });
+                break;
+            case VoxelOctreeNodeMask::VOXEL_OCTANT:
+                if (branch == 0 || branch > view.palette.size()) return false;
+                break;
+            case VoxelOctreeNodeMask::BRICK:
+                if (pending_node.level != 1 || branch >= view.brick_count) return false;
+                break;
+            }
+        }
+    }
+
+    if (next_node_idx != view.nodes.size())
+    {
+        return false;
+    }
+
+    // Brick voxels are local ids, with 0 for empty voxels.
+    for (uint64_t i = 0; i < view.brick_count * 8; i++)
+    {
+        if (PackedArray::read(view.brick_words.data(), view.brick_width, i) > view.palette.size())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::unique_ptr<GrowableBufferResource> create_brick_storage(uint8_t depth)
+{
+    // An octree of depth 8 or more could exceed the reservation in theory, but not with realistic content. Should it,
+    // set_voxel fails instead.
+    uint64_t max_size = depth >= 8 ? BRICK_STORAGE_RESERVE_SIZE : (uint64_t(1) << (3 * depth)) * sizeof(uint32_t);
+
+    return GrowableBufferResource::create(max_size);
+}
+
+static uint64_t get_max_node_count(uint8_t depth)
+{
+    // Every level above the bricks holds up to 8 times as many nodes as the one above it.
+    if (depth >= 9) return FreeList<VoxelOctreeNode>::DEFAULT_MAX_CAPACITY;
+
+    return ((uint64_t(1) << (3 * (depth - 1))) - 1) / 7;
 }
@@ -1,46 +1,257 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
 
 #include "container/free_list.hpp"
+#include "container/growable_buffer_resource.hpp"
+#include "container/packed_array.hpp"
+#include "math/ray.hpp"
 #include "math/vector3.hpp"
 #include "voxel/voxel.hpp"
+#include "voxel/voxel_palette.hpp"
 
 enum class VoxelOctreeNodeMask : uint16_t
 {
     ABSENT_OCTANT   = 0b00,
     OCTANT          = 0b01,
     VOXEL_OCTANT    = 0b10,
-    VOXEL           = 0b11
+    BRICK           = 0b11
 };
 
 struct VoxelOctreeNode
 {
-    // Either points to a VoxelOctreeNode or a Voxel.
+    // Either points to a VoxelOctreeNode, a brick or holds a local voxel id.
     uint32_t branches[8];
     uint16_t masks;             // 0x00 -> Absence of octant.
                                 // 0x01 -> Octant.
-                                // 0x10 -> Voxel octant.
-                                // 0x11 -> Voxel.
+                                // 0x10 -> Voxel octant, filled with a single voxel.
+                                // 0x11 -> Brick of 8 leaf voxels. Only used by nodes one level above the leaves.
 
     void set_branch_mask(uint32_t branch_idx, uint16_t mask);
-    uint16_t get_branch_mask(uint32_t branch_idx);
+    uint16_t get_branch_mask(uint32_t branch_idx) const;
+};
+
+/**
+ * @brief The header of a linearized octree.
+ *
+ * A linearized octree is a single allocation-free blob that can be read in place, for example from a memory mapped
+ * file. The header is followed by the nodes in depth-first order, the palette and the packed brick words. Every
+ * section starts at an 8 byte aligned offset.
+ */
+struct LinearVoxelOctreeHeader
+{
+    uint32_t magic;
+    uint8_t depth;
+    uint8_t brick_width;
+    uint16_t reserved;
+    uint32_t node_count;
+    uint32_t palette_size;
+    uint64_t brick_count;
+
+    static constexpr uint32_t MAGIC = 0x4F58'4F56; // "VOXO"
+};
+
+/**
+ * @brief The first voxel a ray hits.
+ */
+struct VoxelRaycastHit
+{
+    vector3i position;
+    uint32_t voxel_index;
+
+    // The outward normal of the face the ray entered through. Zero if the ray starts inside the voxel.
+    vector3i normal;
+
+    // The distance along the ray, in units of its direction.
+    float distance;
+};
+
+/**
+ * @brief A read-only view of octree data that is not necessarily owned by a \ref VoxelOctree.
+ */
+struct VoxelOctreeView
+{
+    uint8_t depth;
+
+    std::span<const VoxelOctreeNode> nodes;
+    std::span<const uint32_t> palette;
+    std::span<const uint64_t> brick_words;
+    uint8_t brick_width;
+
+    uint64_t brick_count;
+
+    /**
+     * @brief Creates a view of a linearized octree, validating its layout.
+     */
+    static std::optional<VoxelOctreeView> from_linear(std::span<const uint8_t> data);
+
+    /**
+     * @brief Returns the global voxel index at an interleaved position, if a voxel is present there.
+     */
+    std::optional<uint32_t> get_voxel(uint64_t ipos) const;
+
+    /**
+     * @brief Finds the first voxel along a ray within `t_max`, in voxel units relative to the corner of the octree.
+     *
+     * Walks the children of every node front to back and skips absent octants, so empty space costs one 8-wide box
+     * test per node rather than one step per voxel.
+     */
+    std::optional<VoxelRaycastHit> raycast(const Ray& ray, float t_max) const;
+
+    uint32_t get_brick_voxel(uint32_t brick_idx, uint32_t voxel_idx) const
+    {
+        return PackedArray::read(brick_words.data(), brick_width, brick_idx * 8 + voxel_idx);
+    }
+};
+
+/**
+ * @brief The state of an incremental compaction of a \ref VoxelOctree.
+ *
+ * The nodes and bricks are copied into fresh storage in depth-first order, a bounded amount of nodes at a time.
+ */
+struct VoxelOctreeCompaction
+{
+    struct PendingNode
+    {
+        uint32_t node_idx;
+        uint32_t parent_idx; // Into the compacted nodes. UINT32_MAX for the root.
+        uint32_t branch_idx;
+    };
+
+    std::unique_ptr<GrowableBufferResource> brick_storage;
+
+    FreeList<VoxelOctreeNode> nodes;
+    PackedArray bricks;
+
+    // Nodes left to copy. The top is copied next, which yields depth-first order.
+    std::vector<PendingNode> pending;
+
+    VoxelOctreeCompaction(std::unique_ptr<GrowableBufferResource> brick_storage, uint8_t brick_width)
+        : brick_storage {std::move(brick_storage)}, bricks {brick_width, this->brick_storage.get()} {}
 };
 
 struct VoxelOctree
 {
+    // Interleaved positions are 64 bits, which fit 21 levels.
+    static constexpr uint8_t MAX_DEPTH = 21;
+
+    // Holds the bricks, which grow by reallocating, without leaving their old storage behind. Declared first, as it
+    // must outlive the bricks.
+    std::unique_ptr<GrowableBufferResource> brick_storage;
+
     uint8_t depth;
 
+    // Lives in its own reserved address space, so growing commits pages in place.
     FreeList<VoxelOctreeNode> nodes;
 
+    // Maps the local voxel ids stored in this octree to global voxel indices.
+    VoxelPalette palette;
+
+    // The leaf voxels, stored as local voxel ids in groups of 8 per brick. The element width grows with the palette.
+    PackedArray bricks;
+
+    // Bricks no longer referenced by a node, reused before the bricks grow. Compaction drops them.
+    std::vector<uint32_t> free_bricks;
+
+    // Set while the octree reads from data it does not own, e.g. a memory mapped region file.
+    std::optional<VoxelOctreeView> mapped;
+
+    // Optionally keeps the data behind `mapped` alive.
+    std::shared_ptr<const void> mapped_owner;
+
+    // Edits scatter new nodes and bricks over the storage, which compaction puts back in depth-first order.
+    uint32_t edits_since_compaction = 0;
+    std::unique_ptr<VoxelOctreeCompaction> compaction;
+
     VoxelOctree() = default;
 
+    explicit VoxelOctree(std::unique_ptr<GrowableBufferResource> brick_storage);
+
+    VoxelOctree(VoxelOctree&&) = default;
+
+    VoxelOctree& operator = (VoxelOctree&& other);
+
+    /**
+     * @brief Creates an empty octree.
+     *
+     * @param depth The depth of the octree. Must be at least 2, as the leaf voxels are grouped into bricks, and at most
+     * \ref MAX_DEPTH.
+     */
     static std::optional<VoxelOctree> create(uint8_t depth);
 
+    /**
+     * @brief Creates an octree that reads straight from a view, without copying it.
+     *
+     * The viewed data must outlive the octree, unless `owner` keeps it alive. It is copied the first time the octree is
+     * edited, which releases the owner.
+     */
+    static VoxelOctree create_mapped(VoxelOctreeView view, std::shared_ptr<const void> owner = nullptr);
+
+    /**
+     * @brief Creates an octree that owns a copy of the viewed data.
+     */
+    static std::optional<VoxelOctree> create_from_view(const VoxelOctreeView& view);
+
     static uint64_t interleave_octree_coordinate(vector3i pos);
     static uint64_t interleave_octree_coordinate(uint64_t x, uint64_t y, uint64_t z);
 
-    void set_voxel(uint64_t ipos, uint32_t voxel_idx);
+    /**
+     * @brief Sets a leaf voxel, splitting octants and allocating bricks as needed. Bricks and nodes that end up holding
+     * a single voxel are merged back into a voxel octant.
+     *
+     * @return false if the octree ran out of storage for its nodes or bricks. The octree stays valid, but the voxel may
+     * not be set.
+     */
+    bool set_voxel(uint64_t ipos, uint32_t voxel_idx);
+
+    std::optional<uint32_t> get_voxel(uint64_t ipos) const { return get_view().get_voxel(ipos); }
+
+    /**
+     * @brief Returns a view of the octree data, whether it is owned or mapped.
+     */
+    VoxelOctreeView get_view() const;
+
+    /**
+     * @brief Serializes the octree into the linear format described by \ref LinearVoxelOctreeHeader.
+     *
+     * Nodes and bricks are written in depth-first order, which drops any unused slots.
+     */
+    std::vector<uint8_t> linearize() const;
+
+    /**
+     * @brief Returns whether enough edits happened for compaction to be worthwhile.
+     */
+    bool needs_compaction() const;
 
+    /**
+     * @brief Continues compacting the octree, copying at most `node_budget` nodes. Editing the octree restarts
+     * compaction.
+     *
+     * @return The amount of nodes copied, which may equal the budget on the last step. Compaction finished once
+     * `compaction` is null again.
+     */
+    uint32_t compact_step(uint32_t node_budget);
+
+    uint64_t get_brick_count() const { return bricks.size / 8; }
+
+    uint64_t get_node_count() const { return mapped.has_value() ? mapped->nodes.size() : nodes.get_live_count(); }
+
+    /**
+     * @brief Returns the amount of heap memory in bytes used by this octree.
+     */
+    uint64_t get_memory_usage() const;
+
+private:
+    void set_local_voxel(uint64_t ipos, uint32_t local_voxel_idx);
+
+    /**
+     * @brief Merges the brick holding a leaf back into a voxel octant if all of its voxels are equal, and continues up
+     * through every node that became uniform.
+     */
     void compress_from_leaf(uint64_t leaf_pos);
+
+    uint32_t allocate_brick(uint32_t local_voxel_idx);
 };
@@ -0,0 +1,47 @@
+#include "voxel/voxel_palette.hpp"
+
+std::optional<uint32_t> VoxelPalette::find_local_index(uint32_t global_index) const
+{
+    // Chunks rarely contain more than a handful of voxel types, so a linear scan beats hashing here.
+    for (uint32_t i = 0; i < global_indices.size(); i++)
+    {
+        if (global_indices[i] == global_index)
+        {
+            return i + 1;
+        }
+    }
+
+    return std::nullopt;
+}
+
+uint32_t VoxelPalette::get_or_insert_local_index(uint32_t global_index)
+{
+    auto local_index = find_local_index(global_index);
+
+    if (local_index.has_value())
+    {
+        return *local_index;
+    }
+
+    global_indices.push_back(global_index);
+
+    return global_indices.size();
+}
+
+uint8_t VoxelPalette::get_required_width() const
+{
+    // Include the reserved empty id.
+    return get_required_width(global_indices.size() + 1);
+}
+
+uint8_t VoxelPalette::get_required_width(uint64_t entry_count)
+{
+    uint8_t width = 1;
+
+    while (width < 32 && (1ull << width) < entry_count)
+    {
+        width *= 2;
+    }
+
+    return width;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Maps chunk local voxel ids to global voxel indices.
+ *
+ * Local id 0 is reserved and represents the absence of a voxel, so the first registered voxel receives local id 1.
+ * Local ids are handed out densely, which allows them to be stored using the minimum amount of bits required for the
+ * amount of voxel types present in a chunk.
+ */
+struct VoxelPalette
+{
+    static constexpr uint32_t EMPTY_LOCAL_INDEX = 0;
+
+    // Global voxel indices, indexed by local id - 1.
+    std::pmr::vector<uint32_t> global_indices;
+
+    std::optional<uint32_t> find_local_index(uint32_t global_index) const;
+
+    /**
+     * @brief Returns the local id of a global voxel index, adding it to the palette if it is not yet present.
+     */
+    uint32_t get_or_insert_local_index(uint32_t global_index);
+
+    /**
+     * @brief Returns the global voxel index of a local id. The local id must not be \ref EMPTY_LOCAL_INDEX.
+     */
+    uint32_t get_global_index(uint32_t local_index) const { return global_indices[local_index - 1]; }
+
+    /**
+     * @brief Returns the amount of bits (1, 2, 4, 8, 16 or 32) needed to store every local id of this palette.
+     */
+    uint8_t get_required_width() const;
+
+    static uint8_t get_required_width(uint64_t entry_count);
+};
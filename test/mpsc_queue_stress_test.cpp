@@ -0,0 +1,92 @@
+// Pushes from many producer threads into a small queue while a single consumer pops, and checks that every element
+// arrives exactly once and in the order its producer pushed it.
+
+#include <thread>
+#include <vector>
+
+#include <simple-logger.hpp>
+
+#include "container/mpsc_queue.hpp"
+
+static constexpr uint32_t PRODUCER_COUNT = 16;
+static constexpr uint32_t PUSH_COUNT = 100'000;
+
+// Small, so producers keep running into a full queue.
+static constexpr uint64_t QUEUE_CAPACITY = 64;
+
+struct StressElement
+{
+    uint32_t producer_idx;
+    uint32_t push_idx;
+};
+
+int main()
+{
+    auto queue = MpscQueue<StressElement>::create(QUEUE_CAPACITY);
+
+    std::vector<std::thread> producers;
+
+    for (uint32_t producer_idx = 0; producer_idx < PRODUCER_COUNT; producer_idx++)
+    {
+        producers.emplace_back([&queue, producer_idx]() {
+            for (uint32_t push_idx = 0; push_idx < PUSH_COUNT; push_idx++)
+            {
+                while (!queue->try_push(StressElement { producer_idx, push_idx }))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<uint32_t> next_push_indices(PRODUCER_COUNT, 0);
+    uint64_t popped_count = 0;
+    uint64_t error_count = 0;
+
+    while (popped_count < uint64_t(PRODUCER_COUNT) * PUSH_COUNT)
+    {
+        if (queue->get_size() > QUEUE_CAPACITY)
+        {
+            error_count++;
+        }
+
+        auto element = queue->try_pop();
+
+        if (!element.has_value())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (element->producer_idx >= PRODUCER_COUNT || element->push_idx != next_push_indices[element->producer_idx])
+        {
+            error_count++;
+        }
+        else
+        {
+            next_push_indices[element->producer_idx]++;
+        }
+
+        popped_count++;
+    }
+
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+
+    if (queue->try_pop().has_value() || queue->get_size() != 0)
+    {
+        error_count++;
+    }
+
+    if (error_count > 0)
+    {
+        sl::log_error("The queue lost, duplicated or reordered {} elements.", error_count);
+        return 1;
+    }
+
+    sl::log_info("Popped {} elements from {} producers in order.", popped_count, PRODUCER_COUNT);
+
+    return 0;
+}